@@ -0,0 +1,104 @@
+#!/bin/sh
+
+# Compile throughput benchmark, run by `make bench-compile`.
+# Reports lines per second and peak RSS for each input, and fails if any of
+# them is more than BENCH_THRESHOLD percent (default 25) worse than the
+# baseline. With --update the baseline is replaced by the new results. The
+# baseline depends on the machine, so it is not tracked, and nothing is
+# compared until it has been written.
+# Usage: bench/compile.sh compiler work-directory baseline-file [--update]
+
+cc=$1
+dir=$2
+baseline=$3
+update=$4
+threshold=${BENCH_THRESHOLD:-25}
+root=$(dirname "$0")/..
+
+sh "$root/bench/generate.sh" "$dir" || exit 1
+
+# Peak RSS is taken from the kernel, the compiler runs without -fmem-report.
+peak_rss="$dir/peak_rss"
+gcc -O2 "$root/bench/peak_rss.c" -o "$peak_rss" || exit 1
+
+# Some passes recurse along the chain of nodes in a function.
+ulimit -s unlimited 2>/dev/null
+
+results="$dir/results.txt"
+echo "# input lines/s peak-rss-kB" > "$results"
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# measure name flags files...
+measure() {
+	name=$1
+	flags=$2
+	shift 2
+
+	lines=$(cat "$@" | wc -l)
+	rss=0
+	start=$(now_ms)
+
+	for file in "$@"; do
+		if ! file_rss=$("$peak_rss" "$cc" $flags -c "$file" -o "$dir/out.o" 2> /dev/null); then
+			echo "Compiling $file failed."
+			exit 1
+		fi
+
+		if [ "$file_rss" -gt "$rss" ]; then
+			rss=$file_rss
+		fi
+	done
+
+	time_ms=$(($(now_ms) - start))
+	if [ "$time_ms" -eq 0 ]; then
+		time_ms=1
+	fi
+
+	echo "$name $((lines * 1000 / time_ms)) $rss" >> "$results"
+}
+
+measure macros "" "$dir/macros.c"
+measure big_function "" "$dir/big_function.c"
+measure strings "" "$dir/strings.c"
+measure big_struct "" "$dir/big_struct.c"
+measure small_functions "" "$dir/small_functions.c"
+measure self_compile "-I$root/src -I$root -DCONFIG_PATH=\"config.h\"" "$root"/src/*.c "$root"/src/*/*.c
+
+if [ "$update" = "--update" ]; then
+	cp "$results" "$baseline"
+	echo "Updated $baseline."
+	exit 0
+fi
+
+if [ ! -f "$baseline" ]; then
+	awk '!/^#/ { printf("%-16s %10d lines/s %10d kB\n", $1, $2, $3) }' "$results"
+	echo "No baseline to compare with, write one with make bench-compile-baseline."
+	exit 0
+fi
+
+awk -v threshold="$threshold" '
+	FNR == 1 { file++ }
+	/^#/ { next }
+	file == 1 { base_speed[$1] = $2; base_rss[$1] = $3; next }
+	{
+		status = ""
+		if ($1 in base_speed) {
+			if ($2 < base_speed[$1] * (100 - threshold) / 100)
+				status = status " slower"
+			if ($3 > base_rss[$1] * (100 + threshold) / 100)
+				status = status " larger"
+			speed = sprintf("%+.0f%%", 100 * ($2 - base_speed[$1]) / base_speed[$1])
+			rss = sprintf("%+.0f%%", 100 * ($3 - base_rss[$1]) / base_rss[$1])
+		} else {
+			speed = rss = "-"
+		}
+		printf("%-16s %10d lines/s %6s %10d kB %6s%s\n", $1, $2, speed, $3, rss,
+			   status ? " REGRESSION:" status : "")
+		if (status)
+			failed = 1
+	}
+	END { exit failed }
+' "$baseline" "$results"
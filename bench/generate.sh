@@ -0,0 +1,71 @@
+#!/bin/sh
+
+# Generates the deterministic inputs used by compile.sh.
+# Usage: bench/generate.sh output-directory
+
+out=$1
+mkdir -p "$out"
+
+# Thousands of macros in a header, and deeply nested expansions.
+awk 'BEGIN {
+	for (i = 0; i < 4000; i++)
+		printf("#define MACRO_%d(x) ((x) * %d + MACRO_BASE)\n", i, i);
+	print "#define MACRO_BASE 1";
+	print "#define NEST_0 1";
+	for (i = 1; i <= 64; i++)
+		printf("#define NEST_%d (NEST_%d + MACRO_%d(%d))\n", i, i - 1, i, i);
+}' > "$out/macros.h"
+
+awk 'BEGIN {
+	print "#include \"macros.h\"";
+	for (i = 0; i < 4000; i++)
+		printf("int use_%d(int a) { return MACRO_%d(a) + NEST_%d; }\n", i, i, i % 64 + 1);
+}' > "$out/macros.c"
+
+# One function with 100k lines.
+awk 'BEGIN {
+	print "int big_function(int x) {";
+	print "\tint a = x, b = 1, c = 2;";
+	for (i = 0; i < 100000; i++) {
+		if (i % 3 == 0) printf("\ta = a * %d + b;\n", i % 7 + 1);
+		else if (i % 3 == 1) printf("\tb = b ^ (a >> %d);\n", i % 5);
+		else printf("\tc = c + a - b;\n");
+	}
+	print "\treturn a + b + c;";
+	print "}";
+}' > "$out/big_function.c"
+
+# 50k string literals.
+awk 'BEGIN {
+	for (i = 0; i < 50000; i++)
+		printf("const char *string_%d = \"string literal number %d\";\n", i, i);
+}' > "$out/strings.c"
+
+# A struct with 5k members.
+awk 'BEGIN {
+	print "struct big {";
+	for (i = 0; i < 5000; i++)
+		printf("\tint member_%d;\n", i);
+	print "};";
+	print "int sum(struct big *b) {";
+	print "\tint s = 0;";
+	for (i = 0; i < 5000; i += 7)
+		printf("\ts += b->member_%d;\n", i);
+	print "\treturn s;";
+	print "}";
+}' > "$out/big_struct.c"
+
+# Thousands of small functions.
+awk 'BEGIN {
+	for (i = 0; i < 5000; i++) {
+		printf("static int small_%d(int a, int b) {\n", i);
+		printf("\tif (a > b)\n\t\treturn a - b + %d;\n", i);
+		printf("\treturn b - a;\n}\n");
+	}
+	print "int call_all(int x) {";
+	print "\tint s = 0;";
+	for (i = 0; i < 5000; i++)
+		printf("\ts += small_%d(x, %d);\n", i, i);
+	print "\treturn s;";
+	print "}";
+}' > "$out/small_functions.c"
@@ -0,0 +1,35 @@
+// Runs a command and writes its peak RSS in kB to stdout, the same value
+// -fmem-report shows, without instrumenting the compiler. Used by
+// bench/compile.sh. Exits with 1 if the command fails.
+#define _DEFAULT_SOURCE
+
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <stdio.h>
+
+int main(int argc, char **argv) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s command [arguments...]\n", argv[0]);
+		return 1;
+	}
+
+	pid_t pid = fork();
+	if (pid < 0)
+		return 1;
+
+	if (pid == 0) {
+		execvp(argv[1], argv + 1);
+		_exit(127);
+	}
+
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid)
+		return 1;
+
+	printf("%ld\n", usage.ru_maxrss);
+	return !(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
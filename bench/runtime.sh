@@ -0,0 +1,82 @@
+#!/bin/sh
+
+# Generated code benchmark, run by `make bench-runtime`.
+# Builds each kernel in bench/runtime with the compiler under test and with
+# gcc -O0 and gcc -O1, checks that all builds print the same result, and
+# reports the best of BENCH_RUNS (default 3) run times. Instruction counts
+# are reported too when perf is available.
+# Usage: bench/runtime.sh compiler work-directory
+
+cc=$1
+dir=$2
+runs=${BENCH_RUNS:-3}
+root=$(dirname "$0")/..
+
+mkdir -p "$dir" || exit 1
+
+if perf stat -e instructions -x , true > /dev/null 2>&1; then
+	has_perf=1
+else
+	has_perf=0
+fi
+
+now_ms() {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# measure executable, sets time_ms, instructions and output.
+measure() {
+	time_ms=
+	for run in $(seq "$runs"); do
+		start=$(now_ms)
+		output=$("$1") || return 1
+		elapsed=$(($(now_ms) - start))
+		if [ -z "$time_ms" ] || [ "$elapsed" -lt "$time_ms" ]; then
+			time_ms=$elapsed
+		fi
+	done
+
+	instructions=-
+	if [ "$has_perf" -eq 1 ]; then
+		instructions=$(perf stat -e instructions -x , "$1" 2>&1 > /dev/null |
+					   awk -F , '/instructions/ { print $1 }')
+	fi
+}
+
+printf "%-14s %-8s %10s %10s %16s\n" kernel compiler time-ms vs-gcc-O0 instructions
+
+failed=0
+for source in "$root"/bench/runtime/*.c; do
+	name=$(basename "$source" .c)
+	exe="$dir/$name"
+
+	if ! "$cc" -c "$source" -o "$exe.o" ||
+	   ! gcc "$exe.o" -o "$exe-cc" -no-pie ||
+	   ! gcc -O0 "$source" -o "$exe-gcc-O0" ||
+	   ! gcc -O1 "$source" -o "$exe-gcc-O1"; then
+		echo "Building $name failed."
+		exit 1
+	fi
+
+	expected=
+	for variant in gcc-O0 gcc-O1 cc; do
+		if ! measure "$exe-$variant"; then
+			echo "Running $name ($variant) failed."
+			failed=1
+			continue
+		fi
+
+		if [ -z "$expected" ]; then
+			expected=$output
+			base_ms=$time_ms
+		elif [ "$output" != "$expected" ]; then
+			echo "$name ($variant) printed $output, expected $expected."
+			failed=1
+		fi
+
+		ratio=$(awk -v a="$time_ms" -v b="$base_ms" 'BEGIN { printf("%.2fx", a / (b ? b : 1)) }')
+		printf "%-14s %-8s %10d %10s %16s\n" "$name" "$variant" "$time_ms" "$ratio" "$instructions"
+	done
+done
+
+exit $failed
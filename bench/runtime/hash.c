@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a hashing of generated keys into an open addressing table.
+
+#define TABLE_SIZE (1 << 18)
+#define N_KEYS 150000
+#define ROUNDS 4
+
+struct entry {
+	char key[16];
+	unsigned int hash;
+	int count;
+};
+
+static struct entry table[TABLE_SIZE];
+
+static unsigned int fnv1a(const char *s) {
+	unsigned int h = 2166136261u;
+	for (; *s; s++) {
+		h ^= (unsigned char)*s;
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static void make_key(char *buffer, unsigned int n) {
+	int len = 0;
+	buffer[len++] = 'k';
+	do {
+		buffer[len++] = 'a' + n % 26;
+		n /= 26;
+	} while (n);
+	buffer[len] = '\0';
+}
+
+static struct entry *lookup(const char *key) {
+	unsigned int h = fnv1a(key);
+	unsigned int idx = h & (TABLE_SIZE - 1);
+
+	while (table[idx].key[0]) {
+		if (table[idx].hash == h && strcmp(table[idx].key, key) == 0)
+			return table + idx;
+		idx = (idx + 1) & (TABLE_SIZE - 1);
+	}
+
+	strcpy(table[idx].key, key);
+	table[idx].hash = h;
+	return table + idx;
+}
+
+int main(void) {
+	char key[16];
+	unsigned long checksum = 0;
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (unsigned int i = 0; i < N_KEYS; i++) {
+			make_key(key, (i * 7919u) % (N_KEYS / 2));
+			lookup(key)->count++;
+		}
+	}
+
+	for (int i = 0; i < TABLE_SIZE; i++) {
+		if (table[i].key[0])
+			checksum = checksum * 33 + table[i].hash + table[i].count;
+	}
+
+	printf("%lu\n", checksum);
+	return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+
+// Switch based bytecode interpreter running a nested counting loop.
+
+enum op {
+	OP_PUSH, OP_LOAD, OP_STORE, OP_ADD, OP_SUB, OP_MUL, OP_MOD,
+	OP_LT, OP_JZ, OP_JMP, OP_HALT
+};
+
+struct instruction {
+	enum op op;
+	int arg;
+};
+
+// for (i = 0; i < 3000; i++)
+//     for (j = 0; j < 1000; j++)
+//         acc = (acc + i * j) % 1000003;
+static struct instruction program[] = {
+	/*  0 */ { OP_PUSH, 0 }, { OP_STORE, 0 },
+	/*  2 */ { OP_LOAD, 0 }, { OP_PUSH, 3000 }, { OP_LT, 0 }, { OP_JZ, 30 },
+	/*  6 */ { OP_PUSH, 0 }, { OP_STORE, 1 },
+	/*  8 */ { OP_LOAD, 1 }, { OP_PUSH, 1000 }, { OP_LT, 0 }, { OP_JZ, 25 },
+	/* 12 */ { OP_LOAD, 2 }, { OP_LOAD, 0 }, { OP_LOAD, 1 }, { OP_MUL, 0 },
+	/* 16 */ { OP_ADD, 0 }, { OP_PUSH, 1000003 }, { OP_MOD, 0 }, { OP_STORE, 2 },
+	/* 20 */ { OP_LOAD, 1 }, { OP_PUSH, 1 }, { OP_ADD, 0 }, { OP_STORE, 1 },
+	/* 24 */ { OP_JMP, 8 },
+	/* 25 */ { OP_LOAD, 0 }, { OP_PUSH, 1 }, { OP_ADD, 0 }, { OP_STORE, 0 },
+	/* 29 */ { OP_JMP, 2 },
+	/* 30 */ { OP_HALT, 0 },
+};
+
+static long run(struct instruction *code, long *variables) {
+	long stack[64];
+	int sp = 0, pc = 0;
+
+	for (;;) {
+		struct instruction *ins = code + pc++;
+		switch (ins->op) {
+		case OP_PUSH: stack[sp++] = ins->arg; break;
+		case OP_LOAD: stack[sp++] = variables[ins->arg]; break;
+		case OP_STORE: variables[ins->arg] = stack[--sp]; break;
+		case OP_ADD: sp--; stack[sp - 1] += stack[sp]; break;
+		case OP_SUB: sp--; stack[sp - 1] -= stack[sp]; break;
+		case OP_MUL: sp--; stack[sp - 1] *= stack[sp]; break;
+		case OP_MOD: sp--; stack[sp - 1] %= stack[sp]; break;
+		case OP_LT: sp--; stack[sp - 1] = stack[sp - 1] < stack[sp]; break;
+		case OP_JZ: if (!stack[--sp]) pc = ins->arg; break;
+		case OP_JMP: pc = ins->arg; break;
+		case OP_HALT: return variables[2];
+		}
+	}
+}
+
+int main(void) {
+	long variables[3] = { 0 };
+	printf("%ld\n", run(program, variables));
+	return 0;
+}
@@ -0,0 +1,35 @@
+#include <stdio.h>
+
+// Dense double precision matrix multiplication.
+
+#define N 300
+
+static double a[N][N], b[N][N], c[N][N];
+
+int main(void) {
+	for (int i = 0; i < N; i++) {
+		for (int j = 0; j < N; j++) {
+			a[i][j] = (double)((i * 3 + j) % 17) / 7.0;
+			b[i][j] = (double)((i + j * 5) % 13) / 3.0;
+		}
+	}
+
+	for (int i = 0; i < N; i++) {
+		for (int j = 0; j < N; j++)
+			c[i][j] = 0;
+		for (int k = 0; k < N; k++) {
+			double aik = a[i][k];
+			for (int j = 0; j < N; j++)
+				c[i][j] += aik * b[k][j];
+		}
+	}
+
+	double sum = 0;
+	for (int i = 0; i < N; i++)
+		for (int j = 0; j < N; j++)
+			sum += c[i][j] * (double)(i + 1);
+
+	// Rounded, the order of additions is the same for all compilers.
+	printf("%.3f\n", sum);
+	return 0;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Quicksort with insertion sort for small ranges, on pseudo random integers.
+
+#define N 200000
+#define ROUNDS 5
+
+static unsigned int seed = 1;
+
+static unsigned int next_random(void) {
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 1;
+}
+
+static void insertion_sort(int *a, int n) {
+	for (int i = 1; i < n; i++) {
+		int v = a[i], j = i - 1;
+		while (j >= 0 && a[j] > v) {
+			a[j + 1] = a[j];
+			j--;
+		}
+		a[j + 1] = v;
+	}
+}
+
+static void quick_sort(int *a, int n) {
+	while (n > 16) {
+		int pivot = a[n / 2], i = 0, j = n - 1;
+		while (i <= j) {
+			while (a[i] < pivot)
+				i++;
+			while (a[j] > pivot)
+				j--;
+			if (i <= j) {
+				int t = a[i];
+				a[i] = a[j];
+				a[j] = t;
+				i++;
+				j--;
+			}
+		}
+		if (j + 1 < n - i) {
+			quick_sort(a, j + 1);
+			a += i;
+			n -= i;
+		} else {
+			quick_sort(a + i, n - i);
+			n = j + 1;
+		}
+	}
+	insertion_sort(a, n);
+}
+
+int main(void) {
+	int *a = malloc(N * sizeof *a);
+	unsigned long checksum = 0;
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (int i = 0; i < N; i++)
+			a[i] = next_random() % 1000000;
+
+		quick_sort(a, N);
+
+		for (int i = 1; i < N; i++) {
+			if (a[i - 1] > a[i]) {
+				printf("not sorted\n");
+				return 1;
+			}
+		}
+
+		for (int i = 0; i < N; i += 97)
+			checksum = checksum * 31 + a[i];
+	}
+
+	printf("%lu\n", checksum);
+	free(a);
+	return 0;
+}
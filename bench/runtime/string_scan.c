@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Scans a generated text for words, lines and a fixed pattern.
+
+#define SIZE (4 << 20)
+#define ROUNDS 3
+
+static int is_space(char c) {
+	return c == ' ' || c == '\n' || c == '\t';
+}
+
+static int count_pattern(const char *text, const char *pattern, int pattern_len) {
+	int count = 0;
+	for (const char *p = text; *p; p++) {
+		int i = 0;
+		while (i < pattern_len && p[i] == pattern[i])
+			i++;
+		if (i == pattern_len)
+			count++;
+	}
+	return count;
+}
+
+int main(void) {
+	char *text = malloc(SIZE + 1);
+	unsigned int seed = 7;
+	static const char letters[] = "etaoinshrdlu ";
+
+	for (int i = 0; i < SIZE; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		text[i] = letters[(seed >> 16) % 13];
+		if ((seed >> 8) % 61 == 0)
+			text[i] = '\n';
+	}
+	text[SIZE] = '\0';
+
+	unsigned long checksum = 0;
+
+	for (int round = 0; round < ROUNDS; round++) {
+		int words = 0, lines = 0, in_word = 0;
+		for (const char *p = text; *p; p++) {
+			if (*p == '\n')
+				lines++;
+			if (is_space(*p)) {
+				in_word = 0;
+			} else if (!in_word) {
+				in_word = 1;
+				words++;
+			}
+		}
+
+		int found = count_pattern(text, "the", 3);
+		checksum = checksum * 131 + words * 7 + lines * 3 + found;
+	}
+
+	printf("%lu\n", checksum);
+	free(text);
+	return 0;
+}
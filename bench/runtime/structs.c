@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Struct heavy code: particles passed and returned by value, and a linked
+// list of records.
+
+#define N_PARTICLES 4096
+#define STEPS 200
+
+struct vec {
+	int x, y, z;
+};
+
+struct particle {
+	struct vec position, velocity;
+	int mass;
+	struct particle *next;
+};
+
+static struct vec vec_add(struct vec a, struct vec b) {
+	return (struct vec) { a.x + b.x, a.y + b.y, a.z + b.z };
+}
+
+static struct vec vec_scale(struct vec a, int s) {
+	return (struct vec) { a.x * s, a.y * s, a.z * s };
+}
+
+static void step(struct particle *p) {
+	p->position = vec_add(p->position, vec_scale(p->velocity, p->mass));
+
+	if (p->position.x > 100000 || p->position.x < -100000)
+		p->velocity.x = -p->velocity.x;
+	if (p->position.y > 100000 || p->position.y < -100000)
+		p->velocity.y = -p->velocity.y;
+	if (p->position.z > 100000 || p->position.z < -100000)
+		p->velocity.z = -p->velocity.z;
+}
+
+int main(void) {
+	struct particle *particles = malloc(N_PARTICLES * sizeof *particles);
+	struct particle *head = NULL;
+
+	for (int i = 0; i < N_PARTICLES; i++) {
+		struct particle *p = particles + i;
+		p->position = (struct vec) { i, -i, i * 2 };
+		p->velocity = (struct vec) { i % 7 - 3, i % 5 - 2, i % 3 - 1 };
+		p->mass = 1 + i % 4;
+		p->next = head;
+		head = p;
+	}
+
+	for (int s = 0; s < STEPS; s++)
+		for (struct particle *p = head; p; p = p->next)
+			step(p);
+
+	unsigned long checksum = 0;
+	for (struct particle *p = head; p; p = p->next) {
+		struct vec v = p->position;
+		checksum = checksum * 17 + (unsigned int)(v.x ^ v.y ^ v.z);
+	}
+
+	printf("%lu\n", checksum);
+	free(particles);
+	return 0;
+}
@@ -185,7 +185,7 @@ static void ms_expr_function(struct node *func, struct type *function_type, stru
 		}
 	}
 
-	func->function.abi_data = ALLOC(abi_data);
+	func->function.abi_data = ARENA_ALLOC(&ir_arena, abi_data);
 }
 
 static void ms_expr_return(struct node *func, struct evaluated_expression *value, struct node **reg_state) {
@@ -278,7 +278,7 @@ void abi_init_microsoft(void) {
 
 	// Initialize the __builtin_va_list typedef.
 	struct symbol_typedef *sym =
-		symbols_add_typedef(sv_from_str("__builtin_va_list"));
+		symbols_add_typedef(intern(sv_from_str("__builtin_va_list")));
 
 	sym->data_type = type_pointer(type_simple(ST_VOID));
 
@@ -292,7 +292,7 @@ void abi_init_mingw_workarounds(void) {
 	// compilation with the mingw libc headers.
 	// It is very annoying that they require va_list to be typedeffed.
 	define_string("_VA_LIST_DEFINED", "1");
-	symbols_add_typedef(sv_from_str("va_list"))->data_type = type_pointer(type_simple(ST_VOID));
+	symbols_add_typedef(intern(sv_from_str("va_list")))->data_type = type_pointer(type_simple(ST_VOID));
 	define_string("_crt_va_start", "__builtin_va_start");
 	define_string("_crt_va_end", "__builtin_va_end");
 	define_string("_crt_va_arg", "__builtin_va_arg");
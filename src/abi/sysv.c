@@ -272,7 +272,7 @@ static struct evaluated_expression sysv_expr_call(struct evaluated_expression *c
 			.variable = variable,
 		};
 	} else if (c.ret_regs_size == 2) {
-		struct node *address = ir_allocate(calculate_size(return_type), 0);
+		struct node *address = ir_allocate(round_up_to_nearest(calculate_size(return_type), 8), 0);
 		ir_store_part_address(address, ret_reg_variables[0], 0);
 		ir_store_part_address(address, ret_reg_variables[1], 8);
 		result = (struct evaluated_expression) {
@@ -360,7 +360,7 @@ static void sysv_expr_function(struct node *func, struct type *type, struct symb
 		abi_data.overflow_position = total_mem_needed + 16;
 	}
 
-	func->function.abi_data = ALLOC(abi_data);
+	func->function.abi_data = ARENA_ALLOC(&ir_arena, abi_data);
 }
 
 static void sysv_expr_return(struct node *func, struct evaluated_expression *value, struct node **reg_state) {
@@ -542,22 +542,22 @@ void abi_init_sysv(void) {
 
 	// Initialize the __builtin_va_list typedef.
 	struct symbol_typedef *sym =
-		symbols_add_typedef(sv_from_str("__builtin_va_list"));
+		symbols_add_typedef(intern(sv_from_str("__builtin_va_list")));
 
 	struct type *uint = type_simple(ST_UINT);
 	struct type *vptr = type_pointer(type_simple(ST_VOID));
 
-	struct field *fields = cc_malloc(sizeof *fields * 4);
+	struct field *fields = arena_alloc(&tu_arena, sizeof *fields * 4);
 	for (int i = 0; i < 4; i++)
 		fields[i].bitfield = -1;
 	fields[0].type = uint;
-	fields[0].name = sv_from_str("gp_offset");
+	fields[0].name = intern(sv_from_str("gp_offset"));
 	fields[1].type = uint;
-	fields[1].name = sv_from_str("fp_offset");
+	fields[1].name = intern(sv_from_str("fp_offset"));
 	fields[2].type = vptr;
-	fields[2].name = sv_from_str("overflow_arg_area");
+	fields[2].name = intern(sv_from_str("overflow_arg_area"));
 	fields[3].type = vptr;
-	fields[3].name = sv_from_str("reg_save_area");
+	fields[3].name = intern(sv_from_str("reg_save_area"));
 
 	struct struct_data *struct_data = register_struct();
 	*struct_data = (struct struct_data) {
@@ -27,6 +27,7 @@ struct arguments arguments_parse(int argc, char **argv) {
 	const char **flags = NULL;
 
 	struct arguments ret = { 0 };
+	ret.optlevel = -1;
 
 	enum state {
 		S_OPERAND,
@@ -38,6 +39,9 @@ struct arguments arguments_parse(int argc, char **argv) {
 		S_FLAG,
 		S_OUTFILE,
 		S_OPTLEVEL,
+		S_JOBS,
+		S_INCLUDE_PCH,
+		S_LANGUAGE,
 
 		S_MT, S_MF
 	} state = S_OPERAND;
@@ -61,11 +65,14 @@ struct arguments arguments_parse(int argc, char **argv) {
 			if (arg[0] == '-' && arg[1] == 'M') {
 				arg += 2;
 
-				if (!*arg)
-					NOTIMP();
+				if (!*arg) {
+					ret.flag_M = 1;
+					continue;
+				}
 
 				int cont = 1, ignore = 0;
 				switch (*arg) {
+				case 'M': ret.flag_MM = 1; cont = 0; break;
 				case 'D': ret.flag_MD = 1; cont = 0; break;
 				case 'T': next_state = S_MT; break;
 				case 'F': next_state = S_MF; break;
@@ -80,6 +87,12 @@ struct arguments arguments_parse(int argc, char **argv) {
 						ERROR_NO_POS("Unrecognized flag: \"%s\"", argv[i]);
 					}
 				}
+			} else if (strcmp(arg, "-include-pch") == 0) {
+				next_state = S_INCLUDE_PCH;
+			} else if (strcmp(arg, "--emit-pch") == 0) {
+				ret.emit_pch = 1;
+			} else if (strcmp(arg, "-x") == 0) {
+				next_state = S_LANGUAGE;
 			} else if (arg[0] == '-' && arg[1] == 's' && arg[2] == 't' && arg[3] == 'd') {
 				// Quietly ignored.
 			} else if (*arg == '-') {
@@ -103,6 +116,7 @@ struct arguments arguments_parse(int argc, char **argv) {
 				case 'L': next_state = S_LIBRARY_DIR; break;
 				case 'l': next_state = S_LIBRARY; break;
 				case 'f': next_state = S_FLAG; break;
+				case 'j': next_state = S_JOBS; break;
 				}
 
 				arg++;
@@ -136,7 +150,23 @@ struct arguments arguments_parse(int argc, char **argv) {
 		} else if (state == S_MF) {
 			ret.mf_path = arg;
 		} else if (state == S_OPTLEVEL) {
-			ret.optlevel = atoi(arg);
+			if (arg[0] == 's' && arg[1] == '\0') {
+				ret.optlevel = 2;
+				ret.optimize_size = 1;
+			} else {
+				ret.optlevel = atoi(arg);
+			}
+		} else if (state == S_INCLUDE_PCH) {
+			ret.include_pch = arg;
+		} else if (state == S_LANGUAGE) {
+			if (strcmp(arg, "c-header") == 0)
+				ret.emit_pch = 1;
+			else if (strcmp(arg, "c") != 0)
+				ERROR_NO_POS("Unsupported language: \"%s\"", arg);
+		} else if (state == S_JOBS) {
+			ret.jobs = atoi(arg);
+			if (ret.jobs < 1)
+				ERROR_NO_POS("Invalid number of jobs: \"%s\"", arg);
 		}
 
 		state = next_state;
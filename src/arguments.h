@@ -3,7 +3,10 @@
 
 struct arguments {
 	int flag_c, flag_g, flag_s, flag_E, flag_S, flag_MD;
-	int optlevel;
+	int flag_M, flag_MM; // Only write dependencies, -MM without system headers.
+	int optlevel; // -1 if no -O option is given.
+	int optimize_size;
+	int jobs;
 
 	const char *outfile;
 
@@ -29,6 +32,10 @@ struct arguments {
 	const char **flags;
 
 	const char *mt_path, *mf_path;
+
+	// -include-pch, and --emit-pch or -x c-header.
+	const char *include_pch;
+	int emit_pch;
 };
 
 struct arguments arguments_parse(int argc, char **argv);
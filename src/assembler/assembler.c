@@ -5,6 +5,7 @@
 #include "linker/elf.h"
 
 #include <common.h>
+#include <writer.h>
 #include <escape_sequence.h>
 #include <inttypes.h>
 #include <codegen/registers.h>
@@ -16,14 +17,14 @@
 
 static int assemble_to_text = 0;
 
-static FILE *out;
+static struct writer out;
 static const char *current_section;
 
 static struct object *out_object;
 
 void asm_reset(void) {
 	assemble_to_text = 0;
-	out = NULL;
+	out = (struct writer) { 0 };
 	current_section = NULL;
 	out_object = NULL;
 }
@@ -32,10 +33,12 @@ void asm_init_text_out(const char *path) {
 	assemble_to_text = 1;
 	current_section = ".text";
 
-	out = fopen(path, "w");
+	FILE *fp = fopen(path, "w");
 
-	if (!out)
+	if (!fp)
 		ICE("Could not open file %s", path);
+
+	writer_init(&out, fp);
 }
 
 void asm_init_object(struct object *object) {
@@ -45,33 +48,35 @@ void asm_init_object(struct object *object) {
 
 void asm_finish(void) {
 	if (assemble_to_text) {
-		fclose(out);
+		FILE *fp = out.fp;
+		writer_finish(&out);
+		fclose(fp);
 	} else {
 		*out_object = *object_finish();
 	}
 }
 
 // Emit.
-static void asm_emit_no_newline(const char *fmt, ...) {
-	if (!assemble_to_text)
-		ICE("Can't emit assembly when writing elf files.");
+// Fragments of instructions are written without formatting.
+static void emit(const char *str) {
+	writer_string(&out, str);
+}
 
-	va_list args;
-	va_start(args, fmt);
-	vfprintf(out, fmt, args);
-	va_end(args);
+static void emit_int(int64_t value) {
+	writer_int(&out, value);
 }
 
 static void emit_label(label_id id) {
-	char buffer[64];
-	rodata_get_label(id, sizeof buffer, buffer);
-	asm_emit_no_newline("%s", buffer);
+	writer_sv(&out, rodata_label_str(id));
 }
 
 void asm_section(const char *section) {
 	if (assemble_to_text) {
-		if (strcmp(section, current_section) != 0)
-			asm_emit_no_newline(".section %s\n", section);
+		if (strcmp(section, current_section) != 0) {
+			emit(".section ");
+			emit(section);
+			emit("\n");
+		}
 		current_section = section;
 	} else {
 		object_set_section(section);
@@ -82,12 +87,12 @@ void asm_comment(const char *fmt, ...) {
 	if (!assemble_to_text)
 		return;
 
+	emit("\t#");
 	va_list args;
 	va_start(args, fmt);
-	fprintf(out, "\t#");
-	vfprintf(out, fmt, args);
-	fprintf(out, "\n");
+	writer_vprintf(&out, fmt, args);
 	va_end(args);
+	emit("\n");
 }
 
 void asm_label(int global, label_id label) {
@@ -95,13 +100,13 @@ void asm_label(int global, label_id label) {
 		object_symbol_set(label, global);
 	} else {
 		if (global) {
-			fprintf(out, ".global ");
+			emit(".global ");
 			emit_label(label);
-			fprintf(out, "\n");
+			emit("\n");
 		}
 
 		emit_label(label);
-		fprintf(out, ":\n");
+		emit(":\n");
 	}
 }
 
@@ -110,13 +115,13 @@ void asm_string(struct string_view str) {
 		object_write((uint8_t *)str.str, str.len);
 		object_write_byte(0);
 	} else {
-		asm_emit_no_newline("\t.string \"");
+		emit("\t.string \"");
 		for (int i = 0; i < str.len; i++) {
 			char buffer[5];
 			character_to_escape_sequence(str.str[i], buffer, 0);
-			asm_emit_no_newline("%s", buffer);
+			emit(buffer);
 		}
-		asm_emit_no_newline("\"\n");
+		emit("\"\n");
 	}
 }
 
@@ -126,48 +131,51 @@ static void asm_emit_operand(struct operand op) {
 	case OPERAND_REG:
 		if (op.reg.upper_byte)
 			NOTIMP();
-		asm_emit_no_newline("%s", get_reg_name(op.reg.reg, op.reg.size));
+		emit(get_reg_name(op.reg.reg, op.reg.size));
 		break;
 	case OPERAND_SSE_REG:
-		asm_emit_no_newline("%%xmm%d", op.sse_reg);
+		emit("%xmm");
+		emit_int(op.sse_reg);
 		break;
 	case OPERAND_STAR_REG:
 		if (op.reg.upper_byte)
 			NOTIMP();
-		asm_emit_no_newline("*%s", get_reg_name(op.reg.reg, op.reg.size));
+		emit("*");
+		emit(get_reg_name(op.reg.reg, op.reg.size));
 		break;
 	case OPERAND_IMM_LABEL:
+		emit("$");
 		if (op.imm_label.label_ == -1) {
-			asm_emit_no_newline("$%" PRIi64, op.imm_label.offset);
+			emit_int(op.imm_label.offset);
 		} else if (op.imm_label.offset) {
-			asm_emit_no_newline("$");
 			emit_label(op.imm_label.label_);
-			asm_emit_no_newline("+%" PRIi64, op.imm_label.offset);
+			emit("+");
+			emit_int(op.imm_label.offset);
 		} else {
-			asm_emit_no_newline("$");
 			emit_label(op.imm_label.label_);
 		}
 		break;
 	case OPERAND_IMM_LABEL_ABSOLUTE:
 		if (op.imm_label.label_ == -1) {
-			asm_emit_no_newline("%" PRIi64, op.imm_label.offset);
+			emit_int(op.imm_label.offset);
 		} else if (op.imm_label.offset) {
 			emit_label(op.imm_label.label_);
-			asm_emit_no_newline("+%" PRIi64, op.imm_label.offset);
+			emit("+");
+			emit_int(op.imm_label.offset);
 		} else {
 			emit_label(op.imm_label.label_);
 		}
 		break;
 	case OPERAND_MEM:
 		if (op.mem.offset)
-			asm_emit_no_newline("%" PRIi64, op.mem.offset);
-		asm_emit_no_newline("(");
+			emit_int(op.mem.offset);
+		emit("(");
 		if (op.mem.base != REG_NONE && op.mem.index == REG_NONE && op.mem.scale == 1) {
-			asm_emit_no_newline("%s", get_reg_name(op.mem.base, 8));
+			emit(get_reg_name(op.mem.base, 8));
 		} else {
 			NOTIMP();
 		}
-		asm_emit_no_newline(")");
+		emit(")");
 		break;
 	}
 }
@@ -190,11 +198,11 @@ static void asm_ins_impl(const char *mnemonic, struct operand ops[4]) {
 
 		if (len == -1) {
 			printf("Could not assemble instruction: \n");
-			out = stdout;
+			writer_init(&out, stdout);
 			assemble_to_text = 1;
 			asm_ins_impl(mnemonic, ops);
 			assemble_to_text = 0;
-			out = NULL;
+			writer_finish(&out);
 			ICE("Assembler error.");
 		}
 
@@ -222,14 +230,16 @@ static void asm_ins_impl(const char *mnemonic, struct operand ops[4]) {
 			}
 			object_write(output, len);
 	} else {
-		asm_emit_no_newline("\t%s ", mnemonic);
+		emit("\t");
+		emit(mnemonic);
+		emit(" ");
 		for (int i = 0; i < 4 && ops[i].type; i++) {
 			if (i)
-				asm_emit_no_newline(", ");
+				emit(", ");
 
 			asm_emit_operand(ops[i]);
 		}
-		asm_emit_no_newline("\n");
+		emit("\n");
 	}
 }
 
@@ -268,9 +278,9 @@ void asm_quad(struct operand op) {
 		default: NOTIMP();
 		}
 	} else {
-		asm_emit_no_newline(".quad ");
+		emit(".quad ");
 		asm_emit_operand(op);
-		asm_emit_no_newline("\n");
+		emit("\n");
 	}
 }
 
@@ -288,9 +298,9 @@ void asm_byte(struct operand op) {
 		default: NOTIMP();
 		}
 	} else {
-		asm_emit_no_newline(".byte ");
+		emit(".byte ");
 		asm_emit_operand(op);
-		asm_emit_no_newline("\n");
+		emit("\n");
 	}
 }
 
@@ -298,7 +308,9 @@ void asm_zero(int len) {
 	if (!assemble_to_text) {
 		object_write_zero(len);
 	} else {
-		asm_emit_no_newline(".zero %d\n", len);
+		emit(".zero ");
+		emit_int(len);
+		emit("\n");
 	}
 }
 
@@ -306,6 +318,8 @@ void asm_align(int alignment) {
 	if (!assemble_to_text) {
 		object_align(alignment);
 	} else {
-		asm_emit_no_newline(".align %d\n", alignment);
+		emit(".align ");
+		emit_int(alignment);
+		emit("\n");
 	}
 }
@@ -0,0 +1,138 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "cache.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "common.h"
+
+const char *cache_dir = NULL;
+
+// Two independent 64-bit hashes, FNV-1a and a multiply-xorshift.
+// This is not cryptographic, the cache only has to be robust against
+// accidental collisions.
+void cache_key_init(struct cache_key *key) {
+	key->a = 0xcbf29ce484222325ull;
+	key->b = 0x9e3779b97f4a7c15ull;
+}
+
+void cache_key_add(struct cache_key *key, const void *data, size_t size) {
+	const uint8_t *bytes = data;
+	uint64_t a = key->a, b = key->b;
+
+	for (size_t i = 0; i < size; i++) {
+		a = (a ^ bytes[i]) * 0x100000001b3ull;
+		b = (b + bytes[i]) * 0xff51afd7ed558ccdull;
+		b ^= b >> 29;
+	}
+
+	key->a = a;
+	key->b = b;
+}
+
+void cache_key_add_int(struct cache_key *key, int value) {
+	cache_key_add(key, &value, sizeof value);
+}
+
+void cache_key_add_string(struct cache_key *key, const char *str) {
+	// The terminator separates consecutive strings.
+	cache_key_add(key, str, strlen(str) + 1);
+}
+
+void cache_key_add_compiler(struct cache_key *key) {
+	char path[4096];
+	ssize_t len = readlink("/proc/self/exe", path, sizeof path - 1);
+	struct stat st;
+
+	if (len < 0 || stat("/proc/self/exe", &st) != 0)
+		ICE("Could not identify the compiler executable.");
+
+	path[len] = '\0';
+	cache_key_add_string(key, path);
+	cache_key_add(key, &st.st_size, sizeof st.st_size);
+	cache_key_add(key, &st.st_mtim.tv_sec, sizeof st.st_mtim.tv_sec);
+	cache_key_add(key, &st.st_mtim.tv_nsec, sizeof st.st_mtim.tv_nsec);
+}
+
+// Entries are spread over subdirectories named by the first byte of the key.
+static char *entry_path(struct cache_key *key) {
+	return allocate_printf("%s/%02x/%014llx%016llx.o", cache_dir,
+						   (unsigned)(key->a >> 56),
+						   (unsigned long long)(key->a & 0xffffffffffffffull),
+						   (unsigned long long)key->b);
+}
+
+const char *cache_lookup(struct cache_key *key) {
+	char *path = entry_path(key);
+
+	if (access(path, R_OK) != 0) {
+		free(path);
+		return NULL;
+	}
+
+	return path;
+}
+
+const char *cache_begin_store(struct cache_key *key) {
+	mkdir(cache_dir, 0777);
+
+	char *subdir = allocate_printf("%s/%02x", cache_dir, (unsigned)(key->a >> 56));
+	mkdir(subdir, 0777);
+	free(subdir);
+
+	char *path = entry_path(key);
+	char *tmp_path = allocate_printf("%s.%ld.tmp", path, (long)getpid());
+	free(path);
+
+	FILE *fp = fopen(tmp_path, "wb");
+	if (!fp) {
+		free(tmp_path);
+		return NULL;
+	}
+	fclose(fp);
+
+	return tmp_path;
+}
+
+void cache_end_store(struct cache_key *key, const char *tmp_path) {
+	// rename is atomic, concurrent compilations never see partial entries.
+	char *path = entry_path(key);
+	if (rename(tmp_path, path) != 0)
+		remove(tmp_path);
+	free(path);
+}
+
+int cache_copy_file(const char *from, const char *to) {
+	FILE *in = fopen(from, "rb");
+	if (!in)
+		return 0;
+
+	FILE *out = fopen(to, "wb");
+	if (!out) {
+		fclose(in);
+		return 0;
+	}
+
+	char buffer[1 << 16];
+	size_t size;
+	int ok = 1;
+	while ((size = fread(buffer, 1, sizeof buffer, in)) > 0) {
+		if (fwrite(buffer, 1, size, out) != size) {
+			ok = 0;
+			break;
+		}
+	}
+
+	if (ferror(in))
+		ok = 0;
+
+	fclose(in);
+	if (fclose(out) != 0)
+		ok = 0;
+
+	return ok;
+}
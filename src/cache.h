@@ -0,0 +1,34 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Content addressed object cache, enabled by -fcache-dir=.
+// Objects are stored under a key hashed from the preprocessed tokens, the
+// flags that affect code generation, and the identity of the compiler.
+
+extern const char *cache_dir;
+
+struct cache_key {
+	uint64_t a, b;
+};
+
+void cache_key_init(struct cache_key *key);
+void cache_key_add(struct cache_key *key, const void *data, size_t size);
+void cache_key_add_int(struct cache_key *key, int value);
+void cache_key_add_string(struct cache_key *key, const char *str);
+// Path, size and modification time of the running executable.
+void cache_key_add_compiler(struct cache_key *key);
+
+// Returns the path of the cached object, or NULL on a miss.
+const char *cache_lookup(struct cache_key *key);
+
+// The object is written to the returned temporary path, and is moved into
+// the cache by cache_end_store. Returns NULL if the cache is not writable.
+const char *cache_begin_store(struct cache_key *key);
+void cache_end_store(struct cache_key *key, const char *tmp_path);
+
+int cache_copy_file(const char *from, const char *to);
+
+#endif
@@ -666,7 +666,7 @@ static void codegen_function(struct node *func) {
 		rbp_save_info.has_saved_rsp = 1;
 	}
 
-	label_id func_label = register_label_name(sv_from_str((char *)func->function.name));
+	label_id func_label = register_label_name(intern_copy(sv_from_str((char *)func->function.name)));
 	asm_label(func->function.is_global, func_label);
 	asm_ins1("pushq", R8(REG_RBP));
 
@@ -703,10 +703,12 @@ int codegen_get_alloc_preamble(void) {
 	return vla_info.alloc_preamble;
 }
 
-void codegen(void) {
+void codegen_functions(void) {
 	for (struct node *func = first_function; func; func = func->next)
 		codegen_function(func);
+}
 
+void codegen_finish(void) {
 	rodata_codegen();
 	data_codegen();
 
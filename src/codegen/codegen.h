@@ -14,7 +14,10 @@ extern struct codegen_flags {
 	int debug_stack_min;
 } codegen_flags;
 
-void codegen(void);
+// Generates code for the functions in the IR.
+void codegen_functions(void);
+// Generates the data and finishes the output, after all functions.
+void codegen_finish(void);
 int codegen_get_alloc_preamble(void);
 
 // TODO: Why is rdi not destination?
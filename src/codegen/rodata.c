@@ -13,54 +13,96 @@
 #include <inttypes.h>
 #include <assert.h>
 
+enum entry_type {
+	ENTRY_STR,
+	ENTRY_LABEL_NAME,
+	ENTRY_COUNT
+};
+
 struct entry {
-	enum entry_type {
-		ENTRY_STR,
-		ENTRY_LABEL_NAME
-	} type;
-	struct string_view name;
+	enum entry_type type;
+	uint32_t name;
 	label_id id;
 };
 
 static struct entry *entries = NULL;
 static int entries_size = 0, entries_cap = 0;
 
-static label_id label_register(enum entry_type type, struct string_view str) {
-	for (int i = 0; i < entries_size; i++) {
-		if (sv_cmp(entries[i].name, str) &&
-			entries[i].type == type) {
-			return entries[i].id;
-		}
+// Label of each interned name, indexed by name id. 0 means no label,
+// otherwise the label plus one.
+static size_t labels_of_name_cap[ENTRY_COUNT];
+static label_id *labels_of_name[ENTRY_COUNT];
+
+static label_id label_register(enum entry_type type, uint32_t name) {
+	size_t cap = labels_of_name_cap[type];
+	if (name >= cap) {
+		size_t new_cap = MAX(cap * 2, 1024);
+		while (new_cap <= name)
+			new_cap *= 2;
+		labels_of_name[type] = cc_realloc(labels_of_name[type], sizeof *labels_of_name[type] * new_cap);
+		memset(labels_of_name[type] + cap, 0, sizeof *labels_of_name[type] * (new_cap - cap));
+		labels_of_name_cap[type] = new_cap;
 	}
 
+	if (labels_of_name[type][name])
+		return labels_of_name[type][name] - 1;
+
 	int id = entries_size;
 	ADD_ELEMENT(entries_size, entries_cap, entries) = (struct entry) {
 		.type = type,
-		.name = str,
+		.name = name,
 		.id = id
 	};
 
+	labels_of_name[type][name] = id + 1;
+
 	return id;
 }
 
 label_id rodata_register(struct string_view str) {
-	return label_register(ENTRY_STR, str);
+	return label_register(ENTRY_STR, intern_copy(str));
 }
 
-void rodata_get_label(label_id id, int n, char buffer[]) {
-	int res;
+// Spellings of temporary and string labels, computed once and kept for
+// all translation units. Indexed by -id and id respectively.
+static size_t tmp_label_spellings_size, tmp_label_spellings_cap;
+static struct string_view *tmp_label_spellings;
+static size_t str_label_spellings_size, str_label_spellings_cap;
+static struct string_view *str_label_spellings;
+
+static struct string_view numbered_label(size_t *size, size_t *cap, struct string_view **spellings,
+										 const char *prefix, int n) {
+	while ((size_t)n >= *size)
+		ADD_ELEMENT(*size, *cap, *spellings) = (struct string_view) { 0 };
+
+	if (!(*spellings)[n].str)
+		(*spellings)[n] = sv_from_str(allocate_printf("%s%d", prefix, n));
+
+	return (*spellings)[n];
+}
+
+struct string_view rodata_label_str(label_id id) {
 	if (id < 0) { // Temporary label.
-		res = snprintf(buffer, n, ".L%d", -id);
+		return numbered_label(&tmp_label_spellings_size, &tmp_label_spellings_cap,
+							  &tmp_label_spellings, ".L", -id);
 	} else if (entries[id].type == ENTRY_STR) {
-		res = snprintf(buffer, n, ".Ls%d", id);
+		return numbered_label(&str_label_spellings_size, &str_label_spellings_cap,
+							  &str_label_spellings, ".Ls", id);
 	} else if (entries[id].type == ENTRY_LABEL_NAME) {
-		res = snprintf(buffer, n, "%.*s", entries[id].name.len, entries[id].name.str);
-	} else {
-		NOTIMP();
+		return intern_str(entries[id].name);
 	}
 
-	if (res >= n)
+	NOTIMP();
+}
+
+void rodata_get_label(label_id id, int n, char buffer[]) {
+	struct string_view str = rodata_label_str(id);
+
+	if (str.len >= n)
 		ICE("Label name too long");
+
+	memcpy(buffer, str.str, str.len);
+	buffer[str.len] = '\0';
 }
 
 void rodata_codegen(void) {
@@ -71,16 +113,17 @@ void rodata_codegen(void) {
 
 		asm_label(0, entries[i].id);
 
-		asm_string(entries[i].name);
+		asm_string(intern_str(entries[i].name));
 	}
 }
 
-label_id register_label_name(struct string_view str) {
-	return label_register(ENTRY_LABEL_NAME, str);
+label_id register_label_name(uint32_t name) {
+	return label_register(ENTRY_LABEL_NAME, name);
 }
 
+static int tmp_label_idx = -2; // -1 is left for null label.
+
 label_id register_label(void) {
-	static int tmp_label_idx = -2; // -1 is left for null label.
 	return tmp_label_idx--;
 }
 
@@ -95,7 +138,18 @@ struct static_var {
 static struct static_var *static_vars = NULL;
 static int static_vars_size, static_vars_cap;
 
-void data_register_static_var(struct string_view label, struct type *type, struct initializer init, int global, int alignment) {
+void rodata_reset(void) {
+	entries_size = 0;
+	for (int i = 0; i < ENTRY_COUNT; i++) {
+		free(labels_of_name[i]);
+		labels_of_name[i] = NULL;
+		labels_of_name_cap[i] = 0;
+	}
+	static_vars_size = 0;
+	tmp_label_idx = -2;
+}
+
+void data_register_static_var(uint32_t label, struct type *type, struct initializer init, int global, int alignment) {
 	ADD_ELEMENT(static_vars_size, static_vars_cap, static_vars) = (struct static_var) {
 		.label_ = register_label_name(label),
 		.type = type,
@@ -1,21 +1,25 @@
 #ifndef RODATA_H
 #define RODATA_H
 
-#include <string_view.h>
+#include <intern.h>
 
 typedef int label_id;
 
 label_id rodata_register(struct string_view str);
-label_id register_label_name(struct string_view str);
+label_id register_label_name(uint32_t name);
 label_id register_label(void);
 
+// Spelling of the label, valid until the end of the translation unit.
+struct string_view rodata_label_str(label_id id);
 void rodata_get_label(label_id id, int n, char buffer[]);
 
 void rodata_codegen(void);
 
 struct type;
 struct initializer;
-void data_register_static_var(struct string_view label, struct type *type, struct initializer init, int global, int alignment);
+void data_register_static_var(uint32_t label, struct type *type, struct initializer init, int global, int alignment);
 void data_codegen(void);
 
+void rodata_reset(void);
+
 #endif
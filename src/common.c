@@ -1,4 +1,5 @@
 #include "common.h"
+#include "mem_report.h"
 
 #include <stdarg.h>
 #include <limits.h>
@@ -180,19 +181,138 @@ void *cc_malloc(size_t size) {
 	if (!ret)
 		ICE("Allocation error! Probably out of memory.\n");
 
+	if (mem_report_enabled)
+		mem_report_allocation(ret, 0);
+
 	return ret;
 }
 
 void *cc_realloc(void *ptr, size_t size) {
 #undef realloc
+	size_t old_size = mem_report_enabled ? mem_report_usable_size(ptr) : 0;
 	void *ret = realloc(ptr, size);
 
 	if (!ret)
 		ICE("Allocation error! Probably out of memory.\n");
 
+	if (mem_report_enabled)
+		mem_report_allocation(ret, old_size);
+
 	return ret;
 }
 
+struct arena tu_arena, ir_arena, preprocessor_arena;
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_MIN_CHUNK (1 << 16)
+#define ARENA_MAX_CHUNK (1 << 24)
+
+struct arena_chunk {
+	struct arena_chunk *prev;
+	size_t size, used;
+	uint8_t *data;
+};
+
+static size_t arena_align(size_t size) {
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static struct arena_chunk *arena_new_chunk(struct arena *arena, size_t min_size) {
+	size_t size = arena->chunk ? MIN(arena->chunk->size * 2, ARENA_MAX_CHUNK) : ARENA_MIN_CHUNK;
+	size = MAX(size, min_size);
+
+	size_t header_size = arena_align(sizeof (struct arena_chunk));
+	// Chunks are not counted by -fmem-report, arena_alloc counts
+	// the individual allocations instead.
+	struct arena_chunk *chunk = malloc(header_size + size);
+
+	if (!chunk)
+		ICE("Allocation error! Probably out of memory.\n");
+
+	*chunk = (struct arena_chunk) {
+		.prev = arena->chunk,
+		.size = size,
+		.data = (uint8_t *)chunk + header_size
+	};
+
+	arena->chunk = chunk;
+	return chunk;
+}
+
+void *arena_alloc(struct arena *arena, size_t size) {
+	size = arena_align(size);
+
+	struct arena_chunk *chunk = arena->chunk;
+	if (!chunk || chunk->used + size > chunk->size)
+		chunk = arena_new_chunk(arena, size);
+
+	void *ret = chunk->data + chunk->used;
+	chunk->used += size;
+	arena->last = ret;
+
+	if (mem_report_enabled)
+		mem_report_add(size);
+
+	return ret;
+}
+
+void *arena_realloc(struct arena *arena, void *ptr, size_t old_size, size_t size) {
+	if (!ptr)
+		return arena_alloc(arena, size);
+
+	// The last allocation is at the end of the current chunk.
+	struct arena_chunk *chunk = arena->chunk;
+	size_t offset = (uint8_t *)ptr - chunk->data;
+	if (ptr == arena->last && offset + arena_align(size) <= chunk->size) {
+		if (mem_report_enabled && arena_align(size) > arena_align(old_size))
+			mem_report_add(arena_align(size) - arena_align(old_size));
+		chunk->used = offset + arena_align(size);
+		return ptr;
+	}
+
+	void *ret = arena_alloc(arena, size);
+	memcpy(ret, ptr, MIN(old_size, size));
+	return ret;
+}
+
+char *arena_strndup(struct arena *arena, const char *str, size_t len) {
+	char *ret = arena_alloc(arena, len + 1);
+	memcpy(ret, str, len);
+	ret[len] = '\0';
+	return ret;
+}
+
+char *arena_printf(struct arena *arena, const char *fmt, ...) {
+	va_list args1, args2;
+	va_start(args1, fmt);
+	va_copy(args2, args1);
+	int len = vsnprintf(NULL, 0, fmt, args1);
+	char *str = arena_alloc(arena, len + 1);
+	vsprintf(str, fmt, args2);
+	va_end(args1);
+	va_end(args2);
+	return str;
+}
+
+// The largest chunk is kept, so that an arena that is reset for every
+// translation unit or function does not go back to malloc.
+void arena_reset(struct arena *arena) {
+	struct arena_chunk *chunk = arena->chunk;
+	if (!chunk)
+		return;
+
+	struct arena_chunk *prev = chunk->prev;
+	while (prev) {
+		struct arena_chunk *next = prev->prev;
+		free(prev);
+		prev = next;
+	}
+
+	chunk->prev = NULL;
+	chunk->used = 0;
+	arena->last = NULL;
+}
+
 _Noreturn void impl_error_ice(const char *file, int line, const char *fmt, ...) {
 	va_list args1;
 	va_start(args1, fmt);
@@ -207,7 +327,7 @@ _Noreturn void impl_error_ice(const char *file, int line, const char *fmt, ...)
 _Noreturn void impl_error(struct position pos, const char *file, int line, const char *fmt, ...) {
 	va_list va;
 	va_start(va, fmt);
-	printf("\nError: %s:%d:%d: ", pos.path, pos.line, pos.column);
+	printf("\nError: %s:%d:%d: ", pos.path ? pos.path : "<built-in>", pos.line, pos.column);
 	vprintf(fmt, va);
 	printf("\n");
 	printf("Compiler source: %s:%d\n", file, line);
@@ -237,7 +357,7 @@ void impl_warning(struct position pos, const char *fmt, ...) {
 	va_list va;
 	va_start(va, fmt);
 
-	printf("\nWarning, %s:%d:%d: ", pos.path, pos.line, pos.column);
+	printf("\nWarning, %s:%d:%d: ", pos.path ? pos.path : "<built-in>", pos.line, pos.column);
 	vprintf(fmt, va);
 	printf("\n");
 
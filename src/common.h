@@ -71,6 +71,31 @@ void file_write_skip(FILE *fp, size_t target);
 void *cc_malloc(size_t size);
 void *cc_realloc(void *ptr, size_t size);
 
+// Region allocator. Allocation is done by bumping a pointer, and all
+// memory of the arena is released at once by arena_reset.
+struct arena_chunk;
+struct arena {
+	struct arena_chunk *chunk;
+	void *last; // Most recent allocation, can be grown in place.
+};
+
+// Released by parser_reset at the end of each translation unit.
+extern struct arena tu_arena;
+// Released by ir_reset.
+extern struct arena ir_arena;
+// Released by preprocessor_reset.
+extern struct arena preprocessor_arena;
+
+void *arena_alloc(struct arena *arena, size_t size);
+void *arena_realloc(struct arena *arena, void *ptr, size_t old_size, size_t size);
+char *arena_strndup(struct arena *arena, const char *str, size_t len);
+char *arena_printf(struct arena *arena, const char *fmt, ...);
+void arena_reset(struct arena *arena);
+
+#define ARENA_ALLOC(ARENA, ...) memcpy(arena_alloc((ARENA), sizeof (__VA_ARGS__)), &(__VA_ARGS__), sizeof (__VA_ARGS__))
+// Same as ADD_ELEMENT, but for arrays allocated in an arena.
+#define ARENA_ADD_ELEMENT(ARENA, SIZE, CAP, PTR) (*((void)((SIZE) >= (CAP) && (PTR = arena_realloc((ARENA), PTR, sizeof *PTR * (CAP), sizeof *PTR * MAX((CAP) * 2, 1)), CAP = MAX((CAP) * 2, 1))), PTR + (SIZE)++))
+
 int char_to_int(char c);
 
 #include <debug.h>
@@ -273,13 +273,14 @@ const char *dbg_token(struct token *t) {
 	}
 
 	int curr_pos = 0;
+	struct string_view str = token_str(t);
 
 	if (t->type == T_IDENT) {
-		DBG_PRINT("%.*s", t->str.len, t->str.str);
+		DBG_PRINT("%.*s", str.len, str.str);
 	} else if (t->type == T_NUM) {
-		DBG_PRINT("%.*s", t->str.len, t->str.str);
+		DBG_PRINT("%.*s", str.len, str.str);
 	} else if (t->type == T_STRING) {
-		DBG_PRINT("\"%.*s\"", t->str.len, t->str.str);
+		DBG_PRINT("\"%.*s\"", str.len, str.str);
 	} else {
 		DBG_PRINT("%s", dbg_token_type(t->type));
 	}
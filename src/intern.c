@@ -0,0 +1,90 @@
+#include "intern.h"
+
+#include <common.h>
+
+#include <string.h>
+
+static size_t entries_size, entries_cap;
+static struct intern_entry {
+	struct string_view str;
+	uint32_t hash;
+} *entries;
+
+// Open addressing table of ids, 0 marks an empty slot.
+static size_t table_cap;
+static uint32_t *table;
+
+static void table_insert(uint32_t id) {
+	size_t idx = entries[id].hash & (table_cap - 1);
+	while (table[idx])
+		idx = (idx + 1) & (table_cap - 1);
+	table[idx] = id;
+}
+
+static void table_grow(void) {
+	free(table);
+	table_cap = MAX(table_cap * 2, 1024);
+	table = cc_malloc(sizeof *table * table_cap);
+	memset(table, 0, sizeof *table * table_cap);
+
+	for (uint32_t i = 1; i < entries_size; i++)
+		table_insert(i);
+}
+
+static uint32_t *find(struct string_view str, uint32_t hash) {
+	size_t idx = hash & (table_cap - 1);
+	while (table[idx] && (entries[table[idx]].hash != hash ||
+						  !sv_cmp(entries[table[idx]].str, str)))
+		idx = (idx + 1) & (table_cap - 1);
+	return &table[idx];
+}
+
+static uint32_t intern_impl(struct string_view str, int copy) {
+	if (str.len == 0)
+		return 0;
+
+	if (entries_size * 2 >= table_cap) {
+		if (!entries_size)
+			ADD_ELEMENT(entries_size, entries_cap, entries) = (struct intern_entry) { 0 };
+		table_grow();
+	}
+
+	uint32_t hash = sv_hash(str);
+	uint32_t *slot = find(str, hash);
+
+	if (*slot)
+		return *slot;
+
+	if (copy)
+		str.str = arena_strndup(&tu_arena, str.str, str.len);
+
+	*slot = entries_size;
+	ADD_ELEMENT(entries_size, entries_cap, entries) = (struct intern_entry) { str, hash };
+	return *slot;
+}
+
+uint32_t intern(struct string_view str) {
+	return intern_impl(str, 0);
+}
+
+uint32_t intern_copy(struct string_view str) {
+	return intern_impl(str, 1);
+}
+
+struct string_view intern_str(uint32_t id) {
+	if (!id)
+		return (struct string_view) { 0 };
+	return entries[id].str;
+}
+
+uint32_t intern_hash(uint32_t id) {
+	return id ? entries[id].hash : 0;
+}
+
+void intern_reset(void) {
+	free(entries);
+	free(table);
+	entries = NULL;
+	table = NULL;
+	entries_size = entries_cap = table_cap = 0;
+}
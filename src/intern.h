@@ -0,0 +1,26 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <string_view.h>
+
+#include <stdint.h>
+
+// Table of unique strings, identified by dense 32-bit ids.
+// Equal strings always get the same id, so names can be compared and hashed
+// by id. Id 0 is the empty string.
+// Identifiers are interned once by the tokenizer, the ids are then used by
+// the preprocessor, parser and code generator until intern_reset is called
+// at the end of the translation unit.
+
+// The string is referenced, not copied, it must live until intern_reset.
+uint32_t intern(struct string_view str);
+// Same as intern, but copies the string into the translation unit arena.
+uint32_t intern_copy(struct string_view str);
+
+struct string_view intern_str(uint32_t id);
+// Hash of the string, computed once when it was first interned.
+uint32_t intern_hash(uint32_t id);
+
+void intern_reset(void);
+
+#endif
@@ -3,6 +3,7 @@
 #include "global_code_motion.h"
 
 #include <common.h>
+#include <mem_report.h>
 #include <abi/abi.h>
 
 #include <assert.h>
@@ -20,8 +21,13 @@ struct node **seals;
 static size_t nodes_size, nodes_cap;
 struct node **nodes;
 
+size_t ir_node_count(void) {
+	return nodes_size;
+}
+
 struct node *ir_new(int type, int size) {
-	struct node *next = ALLOC((struct node) { .type = type });
+	enum mem_tag prev_tag = mem_tag_set(MEM_IR_NODES);
+	struct node *next = ARENA_ALLOC(&ir_arena, (struct node) { .type = type });
 
 	static int counter;
 	next->index = ++counter;
@@ -30,6 +36,7 @@ struct node *ir_new(int type, int size) {
 	next->parent_function = current_function;
 
 	ADD_ELEMENT(nodes_size, nodes_cap, nodes) = next;
+	mem_tag_set(prev_tag);
 
 	return next;
 }
@@ -82,6 +89,9 @@ void ir_reset(void) {
 	free(seals);
 	seal_size = seal_cap = 0;
 	seals = NULL;
+
+	nodes_size = 0;
+	arena_reset(&ir_arena);
 }
 
 static void set_state(struct node *node);
@@ -113,8 +123,11 @@ void node_set_argument(struct node *node, int index, struct node *argument) {
 		prev->use_size--;
 	}
 
-	if (argument)
-		ADD_ELEMENT(argument->use_size, argument->use_cap, argument->uses) = node;
+	if (argument) {
+		enum mem_tag prev_tag = mem_tag_set(MEM_IR_USES);
+		ARENA_ADD_ELEMENT(&ir_arena, argument->use_size, argument->use_cap, argument->uses) = node;
+		mem_tag_set(prev_tag);
+	}
 	node->arguments[index] = argument;
 
 	if (node->type == IR_PROJECT) {
@@ -771,15 +784,18 @@ void ir_local_schedule_recursive(struct node *node, struct node **end, struct no
 }
 
 static void ir_add_instructions_to_block_children(void) {
+	enum mem_tag prev_tag = mem_tag_set(MEM_BLOCK_CHILDREN);
 	for (unsigned i = 0; i < nodes_size; i++) {
 		struct node *node = nodes[i];
 		struct node *block = node->block;
 		if (node_is_instruction(node) && block) {
-			ADD_ELEMENT(block->block_info.children_size,
-						block->block_info.children_cap,
-						block->block_info.children) = node;
+			ARENA_ADD_ELEMENT(&ir_arena,
+							  block->block_info.children_size,
+							  block->block_info.children_cap,
+							  block->block_info.children) = node;
 		}
 	}
+	mem_tag_set(prev_tag);
 }
 
 void ir_local_schedule(void) {
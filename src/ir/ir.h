@@ -242,6 +242,7 @@ void set_current_function(struct node *function);
 struct node *get_current_block(void);
 
 void ir_reset(void);
+size_t ir_node_count(void);
 
 void ir_calculate_block_local_variables(void);
 
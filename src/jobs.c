@@ -0,0 +1,87 @@
+#define _DEFAULT_SOURCE // For MAP_ANONYMOUS.
+
+#include "jobs.h"
+
+#include "common.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+int jobs_run(int n_tasks, int max_jobs, job_function task, void *data,
+			 size_t result_size, void *results) {
+	int running = 0, next_task = 0, failed = 0;
+
+	size_t shared_size = MAX(result_size * n_tasks, 1);
+	uint8_t *shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+						   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		ICE("Could not map memory for worker results.");
+
+	if (max_jobs < 1)
+		max_jobs = 1;
+
+	// Buffered output would otherwise be written once by every worker.
+	fflush(stdout);
+
+	while (running || (next_task < n_tasks && !failed)) {
+		if (next_task < n_tasks && !failed && running < max_jobs) {
+			pid_t pid = fork();
+
+			if (pid < 0)
+				ICE("Could not start worker process.");
+
+			if (pid == 0) {
+				task(next_task, data, shared + next_task * result_size);
+				fflush(stdout);
+				_exit(EXIT_SUCCESS);
+			}
+
+			next_task++;
+			running++;
+			continue;
+		}
+
+		int status;
+		if (wait(&status) < 0)
+			ICE("Could not wait for worker process.");
+
+		running--;
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+			failed = 1;
+	}
+
+	if (results)
+		memcpy(results, shared, result_size * n_tasks);
+
+	munmap(shared, shared_size);
+
+	return !failed;
+}
+
+const char *jobs_create_temporary_directory(void) {
+	const char *tmp = getenv("TMPDIR");
+	if (!tmp || !*tmp)
+		tmp = "/tmp";
+
+	char *path = allocate_printf("%s/cc-XXXXXX", tmp);
+
+	if (!mkdtemp(path))
+		ICE("Could not create temporary directory in %s", tmp);
+
+	return path;
+}
+
+void jobs_remove_temporary_directory(const char *path, int n_files, const char **files) {
+	for (int i = 0; i < n_files; i++) {
+		if (files[i])
+			remove(files[i]);
+	}
+
+	rmdir(path);
+}
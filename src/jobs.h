@@ -0,0 +1,25 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <stddef.h>
+
+// Simple worker pool used for -j.
+// The compiler keeps almost all of its state in globals, so every task is
+// run in a forked worker process. That process is the compiler context of
+// the translation unit, and is thrown away when the task is done.
+
+// result points to result_size bytes of memory shared with the main process.
+typedef void (*job_function)(int index, void *data, void *result);
+
+// Runs task(0..n_tasks-1) with at most max_jobs workers at the same time.
+// The result of task i is copied to results + i * result_size.
+// Returns 0 if any of the tasks failed, no new tasks are started after that.
+int jobs_run(int n_tasks, int max_jobs, job_function task, void *data,
+			 size_t result_size, void *results);
+
+// Temporary directory that is removed together with its content by
+// jobs_remove_temporary_directory.
+const char *jobs_create_temporary_directory(void);
+void jobs_remove_temporary_directory(const char *path, int n_files, const char **files);
+
+#endif
@@ -1,9 +1,11 @@
 #include "ir/ir.h"
 #include "ir/export_dot.h"
 #include "preprocessor/preprocessor.h"
+#include "preprocessor/macro_report.h"
 #include "parser/parser.h"
 #include "parser/symbols.h"
 #include "codegen/codegen.h"
+#include "codegen/rodata.h"
 #include "common.h"
 #include "assembler/assembler.h"
 #include "linker/elf.h"
@@ -11,6 +13,12 @@
 #include "abi/abi.h"
 #include "arguments.h"
 #include "escape_sequence.h"
+#include "jobs.h"
+#include "time_report.h"
+#include "mem_report.h"
+#include "cache.h"
+#include "intern.h"
+#include "writer.h"
 
 #ifdef CONFIG_PATH
 #include CONFIG_PATH
@@ -18,9 +26,7 @@
 #include "../config.h"
 #endif
 
-#include "optimize/mem2reg.h"
-#include "optimize/remove_dead.h"
-#include "optimize/peephole.h"
+#include "optimize/pass_manager.h"
 
 #include <time.h>
 #include <stdio.h>
@@ -28,6 +34,7 @@
 #include <assert.h>
 
 static const char *dump_ir_path = NULL;
+static const char *time_report_json_path = NULL;
 
 static void add_implementation_defs(void) {
 	define_string("NULL", "(void*)0");
@@ -112,17 +119,202 @@ static void set_flags(struct arguments *arguments) {
 		} else if (strncmp(flag, "dump-ir=", 8) == 0) {
 			dump_ir_path = strdup(flag + 8);
 			printf("Dumping to %s\n", dump_ir_path);
+		} else if (strcmp(flag, "mem-report") == 0) {
+			mem_report_enabled = 1;
+		} else if (strcmp(flag, "macro-report") == 0) {
+			macro_report_enabled = 1;
+		} else if (strncmp(flag, "macro-report=", 13) == 0) {
+			macro_report_enabled = 1;
+			macro_report_limit = atoi(flag + 13);
+		} else if (strcmp(flag, "time-report") == 0) {
+			time_report_enabled = 1;
+		} else if (strncmp(flag, "time-report-json=", 17) == 0) {
+			time_report_enabled = 1;
+			time_report_json_path = strdup(flag + 17);
+		} else if (strncmp(flag, "pass=", 5) == 0) {
+			pass_manager_set_pipeline(flag + 5);
+		} else if (strncmp(flag, "cache-dir=", 10) == 0) {
+			cache_dir = strdup(flag + 10);
 		}
 	}
 }
 
+static void phase_begin(enum time_phase phase) {
+	time_phase_push(phase);
+}
+
+static void phase_end(enum time_phase phase) {
+	time_phase_pop();
+	mem_report_snapshot(time_phase_name(phase));
+}
+
 static size_t object_size, object_cap;
 static struct object *objects;
 
-static void compile_file(const char *path,
-						 struct arguments *arguments) {
-	struct string_view basename = get_basename(path);
+// Flags that only change what is reported, not the generated code.
+static int is_report_flag(const char *flag) {
+	return strncmp(flag, "cache-dir=", 10) == 0 ||
+		strncmp(flag, "time-report", 11) == 0 ||
+		strcmp(flag, "mem-report") == 0 ||
+		strncmp(flag, "macro-report", 12) == 0 ||
+		strncmp(flag, "dump-ir=", 8) == 0;
+}
+
+static void cache_key_from_tokens(struct cache_key *key, struct arguments *arguments,
+								  struct token *tokens, size_t n_tokens) {
+	cache_key_init(key);
+	cache_key_add_compiler(key);
+
+	cache_key_add_int(key, abi);
+	cache_key_add_int(key, mingw_workarounds);
+	cache_key_add_int(key, codegen_flags.code_model);
+	cache_key_add_int(key, codegen_flags.debug_stack_size);
+	cache_key_add_int(key, codegen_flags.debug_stack_min);
+	cache_key_add_int(key, arguments->optlevel);
+	cache_key_add_int(key, arguments->optimize_size);
+
+	for (int i = 0; i < arguments->n_flag; i++) {
+		if (!is_report_flag(arguments->flags[i]))
+			cache_key_add_string(key, arguments->flags[i]);
+	}
+
+	for (size_t i = 0; i < n_tokens; i++) {
+		cache_key_add(key, &tokens[i].type, sizeof tokens[i].type);
+		// The parser ends unsupported pragmas at the end of the line.
+		cache_key_add_int(key, tokens[i].first_of_line | tokens[i].whitespace << 1);
+		struct string_view str = token_str(&tokens[i]);
+		cache_key_add_int(key, str.len);
+		cache_key_add(key, str.str, str.len);
+	}
+}
+
+// Returns 1 if the object was taken from the cache.
+static int fetch_from_cache(struct cache_key *key, const char *outfile,
+							struct arguments *arguments) {
+	const char *entry = cache_lookup(key);
+	if (!entry)
+		return 0;
+
+	if (arguments->flag_c)
+		return cache_copy_file(entry, outfile);
+
+	struct object *object = elf_read_object(entry);
+	if (!object)
+		return 0;
+
+	ADD_ELEMENT(object_size, object_cap, objects) = *object;
+	return 1;
+}
+
+// With -c the object is copied from outfile, otherwise it is the last of
+// objects.
+static void store_in_cache(struct cache_key *key, const char *outfile,
+						   struct arguments *arguments) {
+	const char *tmp_path = cache_begin_store(key);
+	if (!tmp_path)
+		return;
+
+	if (arguments->flag_c) {
+		if (!cache_copy_file(outfile, tmp_path)) {
+			remove(tmp_path);
+			return;
+		}
+	} else {
+		elf_write_object(tmp_path, &objects[object_size - 1]);
+	}
+
+	cache_end_store(key, tmp_path);
+}
+
+// Optimizes the functions in the IR and generates their code, then releases
+// the IR. Called for each function as soon as it is parsed, so only the IR
+// of one function is live at a time.
+static void generate_functions(void) {
+	pass_manager_run();
+
+	if (dump_ir_path)
+		export_dot(dump_ir_path);
+
+	phase_begin(TIME_SCHEDULE_BLOCKS);
+	ir_schedule_blocks();
+	phase_end(TIME_SCHEDULE_BLOCKS);
+
+	phase_begin(TIME_LOCAL_SCHEDULE);
+	ir_local_schedule();
+	phase_end(TIME_LOCAL_SCHEDULE);
+
+	phase_begin(TIME_CODEGEN);
+	ir_calculate_block_local_variables();
+	codegen_functions();
+	phase_end(TIME_CODEGEN);
+
+	ir_reset();
+}
 
+// Parses the translation unit and emits it to outfile, or to objects when
+// linking.
+static void generate_object(const char *outfile, struct arguments *arguments) {
+	struct object out_object = { 0 };
+
+	if (arguments->flag_S) {
+		asm_init_text_out(outfile);
+	} else {
+		asm_init_object(&out_object);
+	}
+
+	// The IR is dumped for the whole translation unit at once.
+	phase_begin(TIME_PARSE);
+	parse_into_ir(dump_ir_path ? NULL : generate_functions);
+	phase_end(TIME_PARSE);
+
+	if (first_function)
+		generate_functions();
+
+	phase_begin(TIME_CODEGEN);
+	codegen_finish();
+	phase_end(TIME_CODEGEN);
+
+	if (arguments->flag_c) {
+		phase_begin(TIME_WRITE_OBJECT);
+		switch (abi) {
+		case ABI_SYSV: elf_write_object(outfile, &out_object); break;
+		case ABI_MICROSOFT: coff_write_object(outfile, &out_object); break;
+		}
+		phase_end(TIME_WRITE_OBJECT);
+	} else if (arguments->flag_S) {
+	} else {
+		ADD_ELEMENT(object_size, object_cap, objects) = out_object;
+	}
+}
+
+// Precompiled headers are only valid for the compiler and target they
+// were written with, and for the same -D, -U and -I options, since the
+// macros saved in them replace the predefined ones.
+static struct cache_key pch_key(struct arguments *arguments) {
+	struct cache_key key;
+	cache_key_init(&key);
+	cache_key_add_compiler(&key);
+	cache_key_add_int(&key, abi);
+	cache_key_add_int(&key, mingw_workarounds);
+
+	cache_key_add_int(&key, arguments->n_define);
+	for (int i = 0; i < arguments->n_define; i++)
+		cache_key_add_string(&key, arguments->defines[i]);
+
+	cache_key_add_int(&key, arguments->n_undefine);
+	for (int i = 0; i < arguments->n_undefine; i++)
+		cache_key_add_string(&key, arguments->undefines[i]);
+
+	cache_key_add_int(&key, arguments->n_include);
+	for (int i = 0; i < arguments->n_include; i++)
+		cache_key_add_string(&key, arguments->includes[i]);
+
+	return key;
+}
+
+// Sets up the predefined macros and include paths of a translation unit,
+// and reads the precompiled header given by -include-pch.
+static void init_translation_unit(struct arguments *arguments) {
 	symbols_init();
 
 	if (mingw_workarounds) {
@@ -137,10 +329,10 @@ static void compile_file(const char *path,
 	add_implementation_defs();
 
 	for (int i = 0; i < arguments->n_include; i++)
-		input_add_include_path(arguments->includes[i]);
+		input_add_include_path(arguments->includes[i], 0);
 
 	for (unsigned i = 0; default_include[i]; i++)
-		input_add_include_path(default_include[i]);
+		input_add_include_path(default_include[i], 1);
 
 	for (int i = 0; default_defs[i]; i++)
 		add_definition(default_defs[i]);
@@ -151,25 +343,58 @@ static void compile_file(const char *path,
 	for (int i = 0; i < arguments->n_undefine; i++)
 		define_remove(arguments->undefines[i]);
 
-	if (arguments->flag_MD)
+	if (arguments->flag_MD || arguments->flag_M || arguments->flag_MM)
 		preprocessor_write_dependencies();
 
-	preprocessor_init(path);
-	parse_into_ir();
+	if (arguments->include_pch)
+		preprocessor_include_pch(arguments->include_pch, pch_key(arguments));
+}
 
-	optimize_mem2reg();
-	optimize_peephole();
-	optimize_remove_dead();
+// TODO: The compiler currently relies too heavily on global state.
+static void reset_translation_unit(void) {
+	preprocessor_reset();
+	ir_reset();
+	asm_reset();
+	rodata_reset();
+	parser_reset();
+	intern_reset();
+}
 
-	if (dump_ir_path)
-		export_dot(dump_ir_path);
+// Writes the header at path as a precompiled header, to -o or <path>.pch.
+static void emit_pch(const char *path, struct arguments *arguments) {
+	init_translation_unit(arguments);
 
-	ir_schedule_blocks();
-	ir_local_schedule();
+	const char *outfile = arguments->outfile;
+	if (!outfile)
+		outfile = allocate_printf("%s.pch", path);
 
-	ir_calculate_block_local_variables();
+	preprocessor_write_pch(path, outfile, pch_key(arguments));
 
-	struct object out_object = { 0 };
+	reset_translation_unit();
+}
+
+// Writes the make rule of path for -M and -MM, without compiling it.
+static void scan_dependencies(const char *path, FILE *fp, struct arguments *arguments) {
+	init_translation_unit(arguments);
+
+	preprocessor_scan_dependencies(path, arguments->flag_MM);
+
+	const char *mt = arguments->mt_path;
+	if (!mt) {
+		struct string_view basename = get_basename(path);
+		mt = allocate_printf("%.*s.o", basename.len - 2, basename.str);
+	}
+
+	preprocessor_print_dependencies(fp, mt);
+
+	reset_translation_unit();
+}
+
+static void compile_file(const char *path,
+						 struct arguments *arguments) {
+	struct string_view basename = get_basename(path);
+
+	init_translation_unit(arguments);
 
 	const char *outfile = arguments->outfile;
 
@@ -182,22 +407,29 @@ static void compile_file(const char *path,
 			outfile = "a.out";
 	}
 
-	if (arguments->flag_S) {
-		asm_init_text_out(outfile);
+	// Linked objects are only cached as ELF.
+	int use_cache = cache_dir && !arguments->flag_S &&
+		(arguments->flag_c || abi == ABI_SYSV);
+	struct cache_key key = { 0 };
+
+	phase_begin(TIME_PARSE);
+	if (use_cache) {
+		size_t n_tokens;
+		struct token *tokens = preprocessor_init_buffered(path, &n_tokens);
+		cache_key_from_tokens(&key, arguments, tokens, n_tokens);
 	} else {
-		asm_init_object(&out_object);
+		preprocessor_init(path);
 	}
 
-	codegen();
+	int cache_hit = use_cache && fetch_from_cache(&key, outfile, arguments);
 
-	if (arguments->flag_c) {
-		switch (abi) {
-		case ABI_SYSV: elf_write_object(outfile, &out_object); break;
-		case ABI_MICROSOFT: coff_write_object(outfile, &out_object); break;
-		}
-	} else if (arguments->flag_S) {
-	} else {
-		ADD_ELEMENT(object_size, object_cap, objects) = out_object;
+	phase_end(TIME_PARSE);
+
+	if (!cache_hit) {
+		generate_object(outfile, arguments);
+
+		if (use_cache)
+			store_in_cache(&key, outfile, arguments);
 	}
 
 	if (arguments->flag_MD) {
@@ -217,73 +449,161 @@ static void compile_file(const char *path,
 		preprocessor_finish_writing_dependencies(mt_path, mf_path);
 	}
 
-	// TODO: The compiler currently relies too heavily on global state.
-	preprocessor_reset();
-	ir_reset();
-	asm_reset();
-	parser_reset();
+	mem_report_print(path);
+	mem_report_reset();
+	macro_report_print(path);
+
+	reset_translation_unit();
 }
 
 // This function is only called when -E flag is passed.
 // That is: preprocess, but don't compile.
 static void preprocess_file(const char *path, struct arguments *arguments) {
-	symbols_init();
+	init_translation_unit(arguments);
+
+	preprocessor_init_raw(path);
+
+	struct writer out;
+	writer_init(&out, stdout);
+
+	// Position of the current output line in the input.
+	const char *line_path = NULL;
+	int line = 0, line_start = 1;
+
+	for (struct token t = preprocessor_next_raw(); t.type != T_EOI; t = preprocessor_next_raw()) {
+		if (t.first_of_line) {
+			// Tokens of expansions are positioned at the expansion site.
+			struct position pos = token_position(&t);
+
+			if (!pos.path) {
+				// Built-in tokens have no position.
+				if (!line_start) {
+					writer_char(&out, '\n');
+					line++;
+				}
+			} else if (line_path && strcmp(pos.path, line_path) == 0 &&
+					   pos.line > line && pos.line <= line + 8) {
+				for (; line < pos.line; line++)
+					writer_char(&out, '\n');
+			} else {
+				if (!line_start)
+					writer_char(&out, '\n');
+				writer_string(&out, "#line ");
+				writer_int(&out, pos.line);
+				writer_string(&out, " \"");
+				for (const char *c = pos.path; *c; c++) {
+					char escape_seq[5];
+					character_to_escape_sequence(*c, escape_seq, 1);
+					writer_string(&out, escape_seq);
+				}
+				writer_string(&out, "\"\n");
+				line_path = pos.path;
+				line = pos.line;
+			}
+		} else if (t.whitespace) {
+			writer_char(&out, ' ');
+		}
 
-	if (mingw_workarounds) {
-		abi_init_mingw_workarounds();
-	}
+		struct string_view str = token_str(&t);
+		if (str.len)
+			writer_sv(&out, str);
+		else
+			writer_string(&out, dbg_token_type(t.type));
+		line_start = 0;
 
-	switch (abi) {
-	case ABI_SYSV: abi_init_sysv(); break;
-	case ABI_MICROSOFT: abi_init_microsoft(); break;
+		if (t.whitespace_after)
+			writer_char(&out, ' ');
 	}
 
-	add_implementation_defs();
+	writer_char(&out, '\n');
+	writer_finish(&out);
 
-	for (int i = 0; i < arguments->n_include; i++)
-		input_add_include_path(arguments->includes[i]);
+	macro_report_print(path);
 
-	for (unsigned i = 0; default_include[i]; i++)
-		input_add_include_path(default_include[i]);
+	reset_translation_unit();
+}
 
-	for (int i = 0; default_defs[i]; i++)
-		add_definition(default_defs[i]);
+struct parallel_compile {
+	struct arguments *arguments;
+	int *operands;
+	const char **object_paths;
+};
+
+// Statistics returned from each worker.
+struct job_result {
+	struct phase_time times[TIME_PHASE_COUNT];
+	struct pass_stats passes[PASS_COUNT];
+};
+
+static void compile_job(int index, void *data, void *result) {
+	struct parallel_compile *pc = data;
+	int operand = pc->operands[index];
+	struct arguments arguments = *pc->arguments;
+
+	if (pc->object_paths) {
+		// Linking is done by the main process, the worker only
+		// writes the object file.
+		arguments.flag_c = 1;
+		arguments.outfile = pc->object_paths[operand];
+	}
 
-	for (int i = 0; i < arguments->n_define; i++)
-		add_definition(arguments->defines[i]);
+	compile_file(arguments.operands[operand], &arguments);
 
-	for (int i = 0; i < arguments->n_undefine; i++)
-		NOTIMP();
+	struct job_result *job_result = result;
+	time_report_get(job_result->times);
+	pass_manager_get_stats(job_result->passes);
+}
 
-	if (arguments->flag_MD)
-		preprocessor_write_dependencies();
+// Compiles all .c operands on a pool of worker processes.
+// When linking, the objects are written to a temporary directory and
+// their paths are returned, indexed by operand. Otherwise returns NULL.
+static const char **compile_parallel(struct arguments *arguments, int will_link,
+									 const char **tmp_dir) {
+	struct parallel_compile pc = {
+		.arguments = arguments,
+		.operands = cc_malloc(sizeof *pc.operands * arguments->n_operand),
+	};
 
-	preprocessor_init(path);
+	int n_tasks = 0;
+	for (int i = 0; i < arguments->n_operand; i++) {
+		if (is_ext_file(get_basename(arguments->operands[i]), 'c'))
+			pc.operands[n_tasks++] = i;
+	}
 
-	while (T0->type != T_EOI) {
-		if (T0->first_of_line)
-			printf("\n");
-		else if (T0->whitespace)
-			printf(" ");
+	if (will_link) {
+		*tmp_dir = jobs_create_temporary_directory();
+		pc.object_paths = cc_malloc(sizeof *pc.object_paths * arguments->n_operand);
+		for (int i = 0; i < arguments->n_operand; i++)
+			pc.object_paths[i] = NULL;
+		for (int i = 0; i < n_tasks; i++)
+			pc.object_paths[pc.operands[i]] = allocate_printf("%s/%d.o", *tmp_dir, i);
+	}
 
-		printf("%s", dbg_token(T0));
+	struct job_result *results = cc_malloc(sizeof *results * MAX(n_tasks, 1));
 
-		if (T0->whitespace_after)
-			printf(" ");
+	if (!jobs_run(n_tasks, arguments->jobs, compile_job, &pc, sizeof *results, results)) {
+		if (will_link)
+			jobs_remove_temporary_directory(*tmp_dir, arguments->n_operand, pc.object_paths);
+		exit(EXIT_FAILURE);
+	}
 
-		t_next();
+	for (int i = 0; i < n_tasks; i++) {
+		time_report_add(results[i].times);
+		pass_manager_add_stats(results[i].passes);
 	}
 
-	preprocessor_reset();
-	ir_reset();
-	asm_reset();
-	parser_reset();
+	free(results);
+	free(pc.operands);
+
+	return pc.object_paths;
 }
 
 int main(int argc, char **argv) {
 	struct arguments arguments = arguments_parse(argc, argv);
 
-	int will_link = !(arguments.flag_S || arguments.flag_c || arguments.flag_E);
+	int scan = arguments.flag_M || arguments.flag_MM;
+	int will_link = !(arguments.flag_S || arguments.flag_c || arguments.flag_E ||
+					  arguments.emit_pch || scan);
 
 	if (will_link) {
 		printf("Warning! Emitting executables is still work in progress.\n");
@@ -296,15 +616,47 @@ int main(int argc, char **argv) {
 		NOTIMP();
 
 	if (arguments.n_operand != 1 && arguments.outfile &&
-		(arguments.flag_S || arguments.flag_c)) {
+		(arguments.flag_S || arguments.flag_c || arguments.emit_pch)) {
 		ERROR_NO_POS("Can't have multiple input files with -o.");
 	}
 
+	pass_manager_set_level(arguments.optlevel, arguments.optimize_size);
 	set_flags(&arguments);
 
+	// Workers write objects for the target, but only ELF objects can be
+	// read back for linking.
+	int parallel = arguments.jobs > 1 && !arguments.flag_E && !arguments.emit_pch && !scan &&
+		!(abi == ABI_MICROSOFT && will_link);
+
+	// Rules of all files go to the same output, and headers are only read
+	// once.
+	FILE *scan_out = stdout;
+	if (scan) {
+		const char *path = arguments.mf_path ? arguments.mf_path : arguments.outfile;
+		if (path && !(scan_out = fopen(path, "w")))
+			ERROR_NO_POS("Could not open %s", path);
+		input_cache_contents();
+	}
+	const char *tmp_dir = NULL;
+	const char **object_paths = NULL;
+
+	if (parallel)
+		object_paths = compile_parallel(&arguments, will_link, &tmp_dir);
+
 	for (int i = 0; i < arguments.n_operand; i++) {
 		struct string_view basename = get_basename(arguments.operands[i]);
 
+		if (arguments.emit_pch) {
+			emit_pch(arguments.operands[i], &arguments);
+			continue;
+		}
+
+		if (scan) {
+			if (is_ext_file(basename, 'c'))
+				scan_dependencies(arguments.operands[i], scan_out, &arguments);
+			continue;
+		}
+
 		if (arguments.flag_E) {
 			if (is_ext_file(basename, 'c')) {
 				preprocess_file(arguments.operands[i], &arguments);
@@ -315,7 +667,16 @@ int main(int argc, char **argv) {
 		}
 
 		if (is_ext_file(basename, 'c')) {
-			compile_file(arguments.operands[i], &arguments);
+			if (!parallel) {
+				compile_file(arguments.operands[i], &arguments);
+			} else if (will_link) {
+				// Objects are added in operand order, regardless of
+				// which worker finished first.
+				struct object *object = elf_read_object(object_paths[i]);
+				if (!object)
+					ICE("Could not read object from worker: %s", object_paths[i]);
+				ADD_ELEMENT(object_size, object_cap, objects) = *object;
+			}
 		} else if (is_ext_file(basename, 'o')) {
 			assert(!(arguments.flag_S || arguments.flag_c));
 			struct object *object = elf_read_object(arguments.operands[i]);
@@ -328,11 +689,32 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	if (scan_out != stdout)
+		fclose(scan_out);
+
+	if (tmp_dir)
+		jobs_remove_temporary_directory(tmp_dir, arguments.n_operand, object_paths);
+
 	if (will_link) {
+		phase_begin(TIME_LINK);
 		struct executable *executable = linker_link(object_size, objects);
+		phase_end(TIME_LINK);
+
+		phase_begin(TIME_WRITE_EXECUTABLE);
 		elf_write_executable(arguments.outfile ? arguments.outfile : "a.out", executable);
+		phase_end(TIME_WRITE_EXECUTABLE);
+
+		mem_report_print("linking");
 	}
 
+	if (time_report_enabled) {
+		time_report_print(stderr);
+		pass_manager_print_report(stderr);
+	}
+
+	if (time_report_json_path)
+		time_report_write_json(time_report_json_path);
+
 	arguments_free(&arguments);
 
 	return 0;
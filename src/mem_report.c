@@ -0,0 +1,107 @@
+#define _DEFAULT_SOURCE // For malloc_usable_size.
+
+#include "mem_report.h"
+
+// Before common.h, which redefines malloc.
+#include <malloc.h>
+#include <sys/resource.h>
+#include <string.h>
+
+#include "common.h"
+#include "types.h"
+#include "ir/ir.h"
+
+int mem_report_enabled = 0;
+
+static enum mem_tag current_tag = MEM_OTHER;
+static size_t tag_bytes[MEM_TAG_COUNT];
+
+static const char *tag_names[MEM_TAG_COUNT] = {
+	[MEM_OTHER] = "other",
+	[MEM_IR_NODES] = "ir nodes",
+	[MEM_IR_USES] = "ir uses",
+	[MEM_BLOCK_CHILDREN] = "block children",
+	[MEM_TOKEN_LIST] = "token lists",
+	[MEM_HIDE_SET] = "hide sets",
+	[MEM_TYPES] = "types",
+};
+
+static struct snapshot {
+	const char *phase_name;
+	size_t n_nodes, n_types;
+	size_t bytes[MEM_TAG_COUNT];
+	long peak_rss_kb;
+} *snapshots;
+static size_t snapshots_size, snapshots_cap;
+
+enum mem_tag mem_tag_set(enum mem_tag tag) {
+	enum mem_tag prev = current_tag;
+	current_tag = tag;
+	return prev;
+}
+
+size_t mem_report_usable_size(void *ptr) {
+	return ptr ? malloc_usable_size(ptr) : 0;
+}
+
+void mem_report_allocation(void *ptr, size_t old_size) {
+	tag_bytes[current_tag] += malloc_usable_size(ptr) - old_size;
+}
+
+void mem_report_add(size_t size) {
+	tag_bytes[current_tag] += size;
+}
+
+void mem_report_snapshot(const char *phase_name) {
+	if (!mem_report_enabled)
+		return;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	// Phases run once for each function, the largest values of all runs
+	// are kept.
+	struct snapshot *snapshot = NULL;
+	for (size_t i = 0; i < snapshots_size; i++) {
+		if (strcmp(snapshots[i].phase_name, phase_name) == 0)
+			snapshot = snapshots + i;
+	}
+
+	if (!snapshot) {
+		snapshot = &ADD_ELEMENT(snapshots_size, snapshots_cap, snapshots);
+		*snapshot = (struct snapshot) { .phase_name = phase_name };
+	}
+
+	snapshot->n_nodes = MAX(snapshot->n_nodes, ir_node_count());
+	snapshot->n_types = MAX(snapshot->n_types, type_count());
+	for (int i = 0; i < MEM_TAG_COUNT; i++)
+		snapshot->bytes[i] = MAX(snapshot->bytes[i], tag_bytes[i]);
+	snapshot->peak_rss_kb = MAX(snapshot->peak_rss_kb, usage.ru_maxrss);
+}
+
+void mem_report_print(const char *path) {
+	if (!mem_report_enabled)
+		return;
+
+	fprintf(stderr, "Memory report for %s (bytes allocated since start of file, "
+			"largest over all runs of each phase)\n", path);
+	fprintf(stderr, "%-22s %10s %10s", "Phase", "IR nodes", "Types");
+	for (int i = 0; i < MEM_TAG_COUNT; i++)
+		fprintf(stderr, " %14s", tag_names[i]);
+	fprintf(stderr, " %14s\n", "peak RSS (kB)");
+
+	for (size_t i = 0; i < snapshots_size; i++) {
+		struct snapshot *snapshot = snapshots + i;
+		fprintf(stderr, "%-22s %10zu %10zu", snapshot->phase_name,
+				snapshot->n_nodes, snapshot->n_types);
+		for (int j = 0; j < MEM_TAG_COUNT; j++)
+			fprintf(stderr, " %14zu", snapshot->bytes[j]);
+		fprintf(stderr, " %14ld\n", snapshot->peak_rss_kb);
+	}
+}
+
+void mem_report_reset(void) {
+	snapshots_size = 0;
+	for (int i = 0; i < MEM_TAG_COUNT; i++)
+		tag_bytes[i] = 0;
+}
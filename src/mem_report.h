@@ -0,0 +1,40 @@
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#include <stddef.h>
+
+// Memory statistics for -fmem-report.
+// Allocations through cc_malloc and cc_realloc are counted under the
+// currently active tag. Memory released with free() is not subtracted,
+// but growing an array with cc_realloc only counts the difference.
+
+enum mem_tag {
+	MEM_OTHER,
+	MEM_IR_NODES,
+	MEM_IR_USES,
+	MEM_BLOCK_CHILDREN,
+	MEM_TOKEN_LIST,
+	MEM_HIDE_SET,
+	MEM_TYPES,
+	MEM_TAG_COUNT
+};
+
+extern int mem_report_enabled;
+
+// Returns the previous tag, which should be restored after the allocation.
+enum mem_tag mem_tag_set(enum mem_tag tag);
+
+// Called by cc_malloc and cc_realloc.
+size_t mem_report_usable_size(void *ptr);
+void mem_report_allocation(void *ptr, size_t old_size);
+// Called by arena_alloc and arena_realloc.
+void mem_report_add(size_t size);
+
+// Record counters after a phase, phase_name must be a string literal.
+// A phase that runs again, once for each function, keeps the largest value
+// of each counter.
+void mem_report_snapshot(const char *phase_name);
+void mem_report_print(const char *path);
+void mem_report_reset(void);
+
+#endif
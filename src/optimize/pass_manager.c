@@ -0,0 +1,136 @@
+#include "pass_manager.h"
+#include "mem2reg.h"
+#include "peephole.h"
+#include "remove_dead.h"
+
+#include <ir/ir.h>
+#include <common.h>
+#include <time_report.h>
+#include <mem_report.h>
+
+#include <string.h>
+
+static const struct {
+	const char *name;
+	void (*run)(void);
+	enum time_phase phase;
+} passes[] = {
+#define X(A, B, C, D) { B, C, D },
+	PASSES(X)
+#undef X
+};
+
+#define MAX_PIPELINE 32
+static enum pass pipeline[MAX_PIPELINE];
+static int pipeline_size = 0;
+
+static struct pass_stats stats[PASS_COUNT];
+
+static void pipeline_add(enum pass pass) {
+	if (pipeline_size >= MAX_PIPELINE)
+		ERROR_NO_POS("Too many optimization passes, maximum is %d.", MAX_PIPELINE);
+	pipeline[pipeline_size++] = pass;
+}
+
+void pass_manager_set_level(int level, int optimize_size) {
+	// None of the passes increase code size, -Os is the same as -O2.
+	(void)optimize_size;
+
+	pipeline_size = 0;
+
+	if (level == 0)
+		return;
+
+	pipeline_add(PASS_MEM2REG);
+	if (level != 1)
+		pipeline_add(PASS_PEEPHOLE);
+	pipeline_add(PASS_REMOVE_DEAD);
+}
+
+void pass_manager_set_pipeline(const char *names) {
+	pipeline_size = 0;
+
+	while (*names) {
+		int len = 0;
+		while (names[len] && names[len] != ',')
+			len++;
+
+		int found = 0;
+		for (int i = 0; i < PASS_COUNT; i++) {
+			if ((int)strlen(passes[i].name) == len &&
+				strncmp(passes[i].name, names, len) == 0) {
+				pipeline_add(i);
+				found = 1;
+				break;
+			}
+		}
+
+		if (!found)
+			ERROR_NO_POS("Unknown optimization pass: \"%.*s\"", len, names);
+
+		names += len;
+		if (*names == ',')
+			names++;
+	}
+}
+
+// Nodes without uses are dead, even before remove-dead has marked them.
+static long count_live_nodes(void) {
+	struct node **nodes;
+	size_t size;
+	ir_get_node_list(&nodes, &size);
+
+	long count = 0;
+	for (size_t i = 0; i < size; i++) {
+		struct node *node = nodes[i];
+		if (node->type != IR_DEAD &&
+			(node->use_size || node->type == IR_FUNCTION || node->type == IR_RETURN))
+			count++;
+	}
+
+	return count;
+}
+
+void pass_manager_run(void) {
+	for (int i = 0; i < pipeline_size; i++) {
+		enum pass pass = pipeline[i];
+		stats[pass].runs++;
+
+		// Counting nodes walks the whole function, only done for the report.
+		long live_before = time_report_enabled ? count_live_nodes() : 0;
+
+		time_phase_push(passes[pass].phase);
+		passes[pass].run();
+		time_phase_pop();
+		mem_report_snapshot(time_phase_name(passes[pass].phase));
+
+		if (time_report_enabled) {
+			long removed = live_before - count_live_nodes();
+			if (removed > 0)
+				stats[pass].removed_nodes += removed;
+		}
+	}
+}
+
+void pass_manager_get_stats(struct pass_stats out[PASS_COUNT]) {
+	for (int i = 0; i < PASS_COUNT; i++)
+		out[i] = stats[i];
+}
+
+void pass_manager_add_stats(const struct pass_stats in[PASS_COUNT]) {
+	for (int i = 0; i < PASS_COUNT; i++) {
+		stats[i].runs += in[i].runs;
+		stats[i].removed_nodes += in[i].removed_nodes;
+	}
+}
+
+void pass_manager_print_report(FILE *fp) {
+	struct phase_time times[TIME_PHASE_COUNT];
+	time_report_get(times);
+
+	fprintf(fp, "%-22s %10s %10s %14s\n", "Pass", "Runs", "Wall (s)", "Removed nodes");
+	for (int i = 0; i < PASS_COUNT; i++) {
+		fprintf(fp, "%-22s %10d %10.4f %14ld\n", passes[i].name, stats[i].runs,
+				times[passes[i].phase].wall, stats[i].removed_nodes);
+	}
+}
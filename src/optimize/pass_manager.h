@@ -0,0 +1,40 @@
+#ifndef OPTIMIZE_PASS_MANAGER_H
+#define OPTIMIZE_PASS_MANAGER_H
+
+#include <stdio.h>
+
+// Optimization passes run on the IR of one function at a time, the pipeline
+// runs once for each function as soon as it has been parsed.
+// The pipeline is chosen by the -O level, or given with -fpass=a,b,...
+
+#define PASSES(X)													\
+	X(PASS_MEM2REG, "mem2reg", optimize_mem2reg, TIME_MEM2REG)		\
+	X(PASS_PEEPHOLE, "peephole", optimize_peephole, TIME_PEEPHOLE)	\
+	X(PASS_REMOVE_DEAD, "remove-dead", optimize_remove_dead, TIME_REMOVE_DEAD)
+
+enum pass {
+#define X(A, B, C, D) A,
+	PASSES(X)
+#undef X
+	PASS_COUNT
+};
+
+struct pass_stats {
+	int runs;
+	long removed_nodes; // Only counted with -ftime-report.
+};
+
+// Pipeline from the -O level. level is -1 if no -O option was given.
+void pass_manager_set_level(int level, int optimize_size);
+// Pipeline from a comma separated list of pass names, for -fpass=.
+void pass_manager_set_pipeline(const char *names);
+
+void pass_manager_run(void);
+
+// Statistics are copied between processes when compiling with -j.
+void pass_manager_get_stats(struct pass_stats stats[PASS_COUNT]);
+void pass_manager_add_stats(const struct pass_stats stats[PASS_COUNT]);
+
+void pass_manager_print_report(FILE *fp);
+
+#endif
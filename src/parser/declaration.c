@@ -32,7 +32,7 @@ static void accept_attribute(int *is_packed) {
 	TEXPECT(T_LPAR);
 	TEXPECT(T_LPAR);
 
-	struct string_view attribute_name = T0->str;
+	struct string_view attribute_name = token_str(T0);
 
 	TEXPECT(T_IDENT);
 
@@ -56,7 +56,7 @@ struct type_ast {
 
 	union {
 		struct {
-			struct string_view name; // NULL if no name.
+			uint32_t name; // 0 if no name.
 		} terminal;
 
 		struct {
@@ -90,7 +90,7 @@ struct type_ast {
 };
 
 struct type_ast *parse_declarator(int *was_abstract, int *has_symbols);
-struct type *ast_to_type(const struct type_specifiers *ts, const struct type_qualifiers *tq, struct type_ast *ast, struct string_view *name, int allow_tq_in_array);
+struct type *ast_to_type(const struct type_specifiers *ts, const struct type_qualifiers *tq, struct type_ast *ast, uint32_t *name, int allow_tq_in_array);
 
 int parse_struct(struct type_specifiers *ts);
 int parse_enum(struct type_specifiers *ts);
@@ -129,7 +129,7 @@ static int parse_specifier(struct type_specifiers *ts,
 			(TACCEPT(T_KSHORT) && set_sbit(ts, TSF_SHORT)) ||
 			(TACCEPT(T_KLONG) && (set_sbit(ts, TSF_LONG1) &&
 								  set_sbit(ts, TSF_LONG2)))) {
-			ERROR(T0->pos, "Invalid type");
+			ERROR(token_position(T0), "Invalid type");
 		}
 
 		if (prev != ts->specifiers) {
@@ -148,18 +148,16 @@ static int parse_specifier(struct type_specifiers *ts,
 		}
 
 		if (TACCEPT(T_KENUM)) {
-			ERROR(T0->pos, "Not implemented");
+			ERROR(token_position(T0), "Not implemented");
 		}
 
 		if (TACCEPT(T_KATOMIC)) {
-			ERROR(T0->pos, "Not implemented");
+			ERROR(token_position(T0), "Not implemented");
 		}
 
 		if (T0->type == T_IDENT && !*got_ts) {
 			*got_ts = 1;
-			struct string_view name = T0->str;
-
-			struct symbol_typedef *sym = symbols_get_typedef(name);
+			struct symbol_typedef *sym = symbols_get_typedef(T0->spelling);
 
 			if (sym) {
 				ts->data_type = sym->data_type;
@@ -201,7 +199,7 @@ static int parse_specifier(struct type_specifiers *ts,
 			TEXPECT(T_RPAR);
 			struct constant *constant = expression_to_constant(length_expr);
 			if (constant->type != CONSTANT_TYPE || !type_is_simple(constant->data_type, ST_ULLONG)) {
-				ERROR(T0->pos, "_Alignas must have a constant expression or type as argument. %d", constant->data_type->type);
+				ERROR(token_position(T0), "_Alignas must have a constant expression or type as argument. %d", constant->data_type->type);
 			}
 			as->alignment = constant->uint_d;
 			return 1;
@@ -223,7 +221,7 @@ static int parse_specifiers(struct type_specifiers *ts,
 	if (as) *as = (struct alignment_specifiers){ 0 };
 
 	if (ts)
-		ts->pos = T0->pos;
+		ts->pos = token_position(T0);
 	int matched = 0;
 	int got_ts = 0;
 	while (parse_specifier(ts, scs, tq, fs, as, &got_ts)) {
@@ -236,18 +234,18 @@ static int parse_enumerator(struct constant *prev, int first) {
 	if (T0->type != T_IDENT)
 		return 0;
 
-	struct string_view name = T0->str;
+	uint32_t name = T0->spelling;
 	TNEXT();
 
 	struct constant val;
 	if (TACCEPT(T_A)) {
 		struct expr *expr = parse_assignment_expression();
 		if (!expr)
-			ERROR(T0->pos, "Expected expression");
+			ERROR(token_position(T0), "Expected expression");
 			
 		struct constant *ret = expression_to_constant(expr);
 		if (!ret)
-			ERROR(T0->pos, "Could not evaluate constant expression, is of type %d", expr->type);
+			ERROR(token_position(T0), "Could not evaluate constant expression, is of type %d", expr->type);
 
 		val = *ret;
 	} else {
@@ -276,14 +274,14 @@ int parse_enum(struct type_specifiers *ts) {
 	if (!TACCEPT(T_KENUM))
 		return 0;
 
-	struct string_view name = { 0 };
+	uint32_t name = 0;
 
 	if (T0->type == T_IDENT) {
-		name = T0->str;
+		name = T0->spelling;
 		TNEXT();
 	} else {
 		static int anonymous_counter = 0;
-		name = sv_from_str(allocate_printf("<enum-%d>", anonymous_counter++));
+		name = intern(sv_from_str(allocate_printf("<enum-%d>", anonymous_counter++)));
 	}
 
 	if (TACCEPT(T_LBRACE)) {
@@ -299,7 +297,7 @@ int parse_enum(struct type_specifiers *ts) {
 		struct symbol_struct *def = symbols_get_struct_in_current_scope(name);
 
 		if (def && def->type != STRUCT_ENUM)
-			ERROR(T0->pos, "Name not declared as enum.");
+			ERROR(token_position(T0), "Name not declared as enum.");
 
 		if (!def) {
 			def = symbols_add_struct(name);
@@ -309,11 +307,11 @@ int parse_enum(struct type_specifiers *ts) {
 		} else {
 			data = def->enum_data;
 			if (data->is_complete)
-				ERROR(T0->pos, "Redeclaring struct/union");
+				ERROR(token_position(T0), "Redeclaring struct/union");
 		}
 
 		*data = (struct enum_data) {
-			.name = name
+			.name = intern_str(name)
 		};
 
 		ts->data_type = type_simple(ST_INT);
@@ -330,7 +328,7 @@ int parse_enum(struct type_specifiers *ts) {
 		}
 
 		if (def->type != STRUCT_ENUM) {
-			ERROR(T0->pos, "Previously not a enum");
+			ERROR(token_position(T0), "Previously not a enum");
 		}
 
 		ts->data_type = type_simple(ST_INT);
@@ -347,16 +345,16 @@ int parse_struct(struct type_specifiers *ts) {
 		is_union = 1;
 	else
 		return 0;
-	struct string_view name = { 0 };
+	uint32_t name = 0;
 
 	accept_attribute(&is_packed);
 
 	if (T0->type == T_IDENT) {
-		name = T0->str;
+		name = T0->spelling;
 		TNEXT();
 	} else {
 		static int anonymous_counter = 0;
-		name = sv_from_str(allocate_printf("<%d>", anonymous_counter++));
+		name = intern(sv_from_str(allocate_printf("<%d>", anonymous_counter++)));
 	}
 
 	if (TACCEPT(T_LBRACE)) {
@@ -371,14 +369,14 @@ int parse_struct(struct type_specifiers *ts) {
 			int was_abstract = 1;
 			while (1) {
 				struct type *type = NULL;
-				struct string_view name = { 0 };
+				uint32_t name = 0;
 				int bitfield = -1;
 				int needs_bitfield = 0;
 
 				if ((ast = parse_declarator(&was_abstract, 0))) {
 					found_one = 1;
 					if (was_abstract)
-						ERROR(T0->pos, "Can't have abstract in struct declaration");
+						ERROR(token_position(T0), "Can't have abstract in struct declaration");
 
 					type = ast_to_type(&s.ts, &s.tq, ast, &name, 0);
 				} else {
@@ -393,16 +391,16 @@ int parse_struct(struct type_specifiers *ts) {
 					struct constant *c = expression_to_constant(
 						expression_cast(bitfield_expr, type_simple(ST_INT)));
 					if (!c)
-						ERROR(T0->pos, "Bit-field must be a constant expression");
+						ERROR(token_position(T0), "Bit-field must be a constant expression");
 					if (!type_is_simple(c->data_type, ST_INT))
-						ERROR(T0->pos, "Bit-field must an integer");
+						ERROR(token_position(T0), "Bit-field must an integer");
 					assert(c->type == CONSTANT_TYPE);
 					bitfield = c->int_d;
 				} else if (needs_bitfield) {
 					break;
 				}
 
-				ADD_ELEMENT(fields_size, fields_cap, fields) = (struct field) {
+				ARENA_ADD_ELEMENT(&tu_arena, fields_size, fields_cap, fields) = (struct field) {
 					.type = type,
 					.name = name,
 					.bitfield = bitfield
@@ -415,13 +413,13 @@ int parse_struct(struct type_specifiers *ts) {
 
 			if (!found_one) {
 				if (s.ts.data_type->type == TY_STRUCT) {
-					ADD_ELEMENT(fields_size, fields_cap, fields) = (struct field) {
+					ARENA_ADD_ELEMENT(&tu_arena, fields_size, fields_cap, fields) = (struct field) {
 						.type = s.ts.data_type,
-						.name = { 0 },
+						.name = 0,
 						.bitfield = -1
 					};
 				} else {
-					ERROR(T0->pos, "Anonymous member must be struct or bitfield.");
+					ERROR(token_position(T0), "Anonymous member must be struct or bitfield.");
 				}
 			}
 		}
@@ -435,10 +433,10 @@ int parse_struct(struct type_specifiers *ts) {
 
 		if (is_union) {
 			if (def && def->type != STRUCT_UNION)
-				ERROR(T0->pos, "Name not declared as union.");
+				ERROR(token_position(T0), "Name not declared as union.");
 		} else {
 			if (def && def->type != STRUCT_STRUCT)
-				ERROR(T0->pos, "Name not declared as struct.");
+				ERROR(token_position(T0), "Name not declared as struct.");
 		}
 
 		if (!def) {
@@ -449,7 +447,7 @@ int parse_struct(struct type_specifiers *ts) {
 		} else {
 			data = def->struct_data;
 			if (data->is_complete) {
-				ERROR(T0->pos, "Redeclaring struct/union %.*s", name.len, name.str);
+				ERROR(token_position(T0), "Redeclaring struct/union %s", sv_to_str(intern_str(name)));
 			}
 		}
 
@@ -461,7 +459,7 @@ int parse_struct(struct type_specifiers *ts) {
 
 			.fields = fields,
 
-			.name = name
+			.name = intern_str(name)
 		};
 
 		if (is_packed)
@@ -487,16 +485,16 @@ int parse_struct(struct type_specifiers *ts) {
 
 			def->struct_data = register_struct();
 			*def->struct_data = (struct struct_data) {
-				.name = name,
+				.name = intern_str(name),
 				.is_complete = 0,
 			};
 			def->type = is_union ? STRUCT_UNION : STRUCT_STRUCT;
 		}
 
 		if (!is_union && def->type != STRUCT_STRUCT) {
-			ERROR(T0->pos, "%.*s Previously not a struct", name.len, name.str);
+			ERROR(token_position(T0), "%s Previously not a struct", sv_to_str(intern_str(name)));
 		} else if (is_union && def->type != STRUCT_UNION) {
-			ERROR(T0->pos, "Previously not a union");
+			ERROR(token_position(T0), "Previously not a union");
 		}
 
 		struct type params = {
@@ -541,8 +539,8 @@ static void ast_get_parameters(struct type_ast *ast,
 }
 
 static struct type_ast *type_ast_new(struct type_ast ast) {
-	ast.pos = T0->pos;
-	return ALLOC(ast);
+	ast.pos = token_position(T0);
+	return ARENA_ALLOC(&tu_arena, ast);
 }
 
 static struct type *specifiers_to_type(const struct type_specifiers *ts) {
@@ -611,7 +609,7 @@ static struct type *apply_tq(struct type *type, const struct type_qualifiers *tq
 	return type;
 }
 
-struct type *ast_to_type(const struct type_specifiers *ts, const struct type_qualifiers *tq, struct type_ast *ast, struct string_view *name, int allow_tq_in_array) {
+struct type *ast_to_type(const struct type_specifiers *ts, const struct type_qualifiers *tq, struct type_ast *ast, uint32_t *name, int allow_tq_in_array) {
 	struct type *type = specifiers_to_type(ts);
 
 	type = apply_tq(type, tq);
@@ -738,16 +736,14 @@ static struct parameter_list parse_parameter_list(void) {
 
 		ret.n++;
 		ret.types = cc_realloc(ret.types, ret.n * sizeof(*ret.types));
-		struct string_view name = { 0 };
+		uint32_t name = 0;
 		struct type *type = ast_to_type(&s.ts, &s.tq, ast, &name, 1);
 		type = type_adjust_parameter(type);
 		ret.types[ret.n - 1] = type;
 
 		ret.arguments = cc_realloc(ret.arguments, ret.n * sizeof(*ret.arguments));
 		struct symbol_identifier *ident =
-			symbols_add_identifier(was_abstract
-								   ? (struct string_view) { 0 }
-								   : name);
+			symbols_add_identifier(was_abstract ? 0 : name);
 
 		ident->type = IDENT_PARAMETER;
 		ident->parameter.type = type;
@@ -811,19 +807,19 @@ struct type_ast *parse_declarator(int *was_abstract, int *has_symbols) {
 	if (T0->type == T_IDENT) {
 		ast = type_ast_new((struct type_ast){
 				.type = TAST_TERMINAL,
-				.terminal.name = T0->str
+				.terminal.name = T0->spelling
 			});
 		if (was_abstract)
 			*was_abstract = 0;
 		TNEXT();
 	} else if (TACCEPT(T_LPAR)) {
-		if (!(T0->type == T_IDENT && symbols_get_typedef(T0->str)))
+		if (!(T0->type == T_IDENT && symbols_get_typedef(T0->spelling)))
 			ast = parse_declarator(was_abstract, has_symbols);
 		if (!ast) {
 			*was_abstract = 1;
 			ast = type_ast_new((struct type_ast) {
 					.type = TAST_TERMINAL,
-					.terminal.name = { 0 }
+					.terminal.name = 0
 				});
 			ast = parse_function_parameters(ast, has_symbols);
 		} else {
@@ -845,7 +841,7 @@ struct type_ast *parse_declarator(int *was_abstract, int *has_symbols) {
 		if (ast->parent == NULL) {
 			ast->parent = type_ast_new((struct type_ast){
 					.type = TAST_TERMINAL,
-					.terminal.name = { 0 }
+					.terminal.name = 0
 				});
 			*was_abstract = 1;
 		}
@@ -854,7 +850,7 @@ struct type_ast *parse_declarator(int *was_abstract, int *has_symbols) {
 		*was_abstract = 1;
 		ast = type_ast_new((struct type_ast) {
 				.type = TAST_TERMINAL,
-				.terminal.name = { 0 }
+				.terminal.name = 0
 			});
 	} else {
 		*was_abstract = 1; // Is this correct?
@@ -884,14 +880,14 @@ struct type_ast *parse_declarator(int *was_abstract, int *has_symbols) {
 			if (TACCEPT(T_RBRACK)) {
 				arr.array.type = ARR_EMPTY;
 				if (need_expression)
-					ERROR(T0->pos, "Missing expression after static.");
+					ERROR(token_position(T0), "Missing expression after static.");
 			} else if (TACCEPT(T_STAR)) {
 				arr.array.type = ARR_STAR;
 				TEXPECT(T_RBRACK);
 			} else {
 				struct expr *expression = parse_expression();
 				if (!expression)
-					ERROR(T0->pos, "Expected size expression.");
+					ERROR(token_position(T0), "Expected size expression.");
 
 				arr.array.type = ARR_EXPRESSION;
 				arr.array.expr = expression;
@@ -930,7 +926,7 @@ static int match_specific_string(struct type **type, struct initializer *init, s
 
 	if (((*type)->type == TY_ARRAY || (*type)->type == TY_INCOMPLETE_ARRAY) &&
 		(type_is_simple((*type)->children[0], char_type))) {
-		struct string_view str = string_token.str;
+		struct string_view str = token_str(&string_token);
 
 		int braces = TACCEPT(T_LBRACE);
 		TEXPECT(token_type);
@@ -1011,7 +1007,7 @@ static void parse_brace_initializer(struct type **type, struct initializer *init
 				struct expr *expr = expression_cast(parse_expression(), type_simple(ST_ULLONG));
 				struct constant *c = expression_to_constant(expr);
 				if (!c)
-					ERROR(T0->pos, "Expected constant expression in array designator.");
+					ERROR(token_position(T0), "Expected constant expression in array designator.");
 				TEXPECT(T_RBRACK);
 
 				assert(c->type == CONSTANT_TYPE && type_is_simple(c->data_type, ST_ULLONG));
@@ -1023,8 +1019,8 @@ static void parse_brace_initializer(struct type **type, struct initializer *init
 					return;
 				TEXPECT(T_DOT);
 				int n = 0, *indices = 0;
-				if (!type_search_member(current_type, T0->str, &n, &indices))
-					ERROR(T0->pos, "Could not find member of name %s", dbg_token(T0));
+				if (!type_search_member(current_type, T0->spelling, &n, &indices))
+					ERROR(token_position(T0), "Could not find member of name %s", dbg_token(T0));
 
 				TEXPECT(T_IDENT);
 
@@ -1112,7 +1108,7 @@ void parse_initializer_recursive(struct type **type, struct initializer *init, s
 
 		expr = parse_assignment_expression();
 		if (!expr)
-			ERROR(T0->pos, "Expected expression in initializer to %s got %s.", dbg_type(*type), dbg_token(T0));
+			ERROR(token_position(T0), "Expected expression in initializer to %s got %s.", dbg_type(*type), dbg_token(T0));
 
 		if (has_braces)
 			TEXPECT(T_RBRACE);
@@ -1155,7 +1151,7 @@ void parse_initializer_recursive(struct type **type, struct initializer *init, s
 	} else if (is_str && is_aggregate) {
 		parse_brace_initializer(type, init, current_idx, 1, expr);
 	} else {
-		ERROR(T0->pos, "Error initializing %s\n", strdup(dbg_type(*type)));
+		ERROR(token_position(T0), "Error initializing %s\n", strdup(dbg_type(*type)));
 	}
 
 	if ((*type)->type == TY_INCOMPLETE_ARRAY) {
@@ -1164,7 +1160,7 @@ void parse_initializer_recursive(struct type **type, struct initializer *init, s
 		case INIT_BRACE: max_index = init->brace.size; break;
 		case INIT_STRING: NOTIMP();
 		default:
-			ERROR(T0->pos, "Expected incomplete array to be completed in initialzier.");
+			ERROR(token_position(T0), "Expected incomplete array to be completed in initialzier.");
 		}
 
 		struct type complete_array_params = {
@@ -1194,7 +1190,7 @@ struct type *parse_type_name(void) {
 	int was_abstract = 1;
 	struct type_ast *ast = parse_declarator(&was_abstract, 0);
 	if (!was_abstract)
-		ERROR(T0->pos, "Type name must be abstract");
+		ERROR(token_position(T0), "Type name must be abstract");
 
 	struct type *type = ast_to_type(&s.ts, &s.tq, ast, NULL, 0);
 	type_evaluate_vla(type);
@@ -1203,7 +1199,7 @@ struct type *parse_type_name(void) {
 
 struct {
 	size_t size, cap;
-	struct string_view *names;
+	uint32_t *names;
 } potentially_tentative;
 
 static int parse_init_declarator(struct specifiers s, int external, int *was_func) {
@@ -1215,10 +1211,10 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 		return 0;
 
 	if (was_abstract)
-		ERROR(T0->pos, "Declaration can't be abstract");
+		ERROR(token_position(T0), "Declaration can't be abstract");
 
 	struct type *type;
-	struct string_view name;
+	uint32_t name;
 	type = ast_to_type(&s.ts, &s.tq, ast, &name, 0);
 
 	if (T0->type == T_LBRACE) {
@@ -1230,10 +1226,10 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 			symbols_push_scope();
 
 		if (!external)
-			ERROR(T0->pos, "Function definition are not allowed inside functions.");
+			ERROR(token_position(T0), "Function definition are not allowed inside functions.");
 
 		if (arg_n && !args)
-			ERROR(T0->pos, "Should not be null");
+			ERROR(token_position(T0), "Should not be null");
 
 		parse_function(name, type, arg_n, args, s.scs.static_n ? 0 : 1);
 		*was_func = 1;
@@ -1247,7 +1243,7 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 	// Evaluate all unevaluated VLAs.
 	if (external) {
 		if (type_contains_unevaluated_vla(type))
-			ERROR(T0->pos, "Global declaration can't contain VLA.");
+			ERROR(token_position(T0), "Global declaration can't contain VLA.");
 	} else {
 		type_evaluate_vla(type);
 	}
@@ -1267,7 +1263,7 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 		struct type *composite_type = type_make_composite(type, prev_type);
 
 		if (!composite_type)
-			ERROR(T0->pos, "%.*s has conflicting types: %s and %s\n", name.len, name.str, strdup(dbg_type(prev_type)),
+			ERROR(token_position(T0), "%s has conflicting types: %s and %s\n", sv_to_str(intern_str(name)), strdup(dbg_type(prev_type)),
 				  strdup(dbg_type(type)));
 
 		type = composite_type;
@@ -1280,9 +1276,9 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 	// Handle function definitions first, since they differ a bit from the others.
 	if (type->type == TY_FUNCTION) {
 		if (has_init)
-			ERROR(T0->pos, "Function definition can't have initializer.");
+			ERROR(token_position(T0), "Function definition can't have initializer.");
 		if (!external && s.scs.static_n)
-			ERROR(T0->pos, "Function declarations outside file-scope can't be static.");
+			ERROR(token_position(T0), "Function declarations outside file-scope can't be static.");
 
 		symbol->type = IDENT_LABEL;
 		symbol->label.name = name;
@@ -1297,7 +1293,7 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 	int is_tentative = 0;
 
 	if (s.scs.extern_n && has_init)
-		ERROR(T0->pos, "Extern declaration can't have initializer.");
+		ERROR(token_position(T0), "Extern declaration can't have initializer.");
 
 	if (s.scs.register_n)
 		symbol->is_register = 1;
@@ -1345,7 +1341,8 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 
 			if (!external) {
 				static int local_var = 0;
-				name = sv_from_str(allocate_printf(".LVAR%d%.*s", local_var++, name.len, name.str));
+				struct string_view str = intern_str(name);
+				name = intern(sv_from_str(allocate_printf(".LVAR%d%.*s", local_var++, str.len, str.str)));
 			}
 
 			symbol->label.name = name;
@@ -1365,7 +1362,7 @@ static int parse_init_declarator(struct specifiers s, int external, int *was_fun
 				symbol->variable.type = type;
 
 				if (has_init)
-					ERROR(T0->pos, "Variable length array can't have initializer");
+					ERROR(token_position(T0), "Variable length array can't have initializer");
 			} else {
 				symbol->type = IDENT_VARIABLE;
 				struct node *ptr;
@@ -1402,25 +1399,25 @@ int parse_declaration(int external) {
 			struct expr *expr = EXPR_BINARY_OP(OP_EQUAL, EXPR_INT(0), parse_assignment_expression());
 			struct constant *constant = expression_to_constant(expr);
 			if (!constant)
-				ERROR(T0->pos, "Expresison in _Static_assert must be constant.");
+				ERROR(token_position(T0), "Expresison in _Static_assert must be constant.");
 
 			assert(constant->type == CONSTANT_TYPE);
 
 			if (!type_is_simple(constant->data_type, ST_INT))
-				ERROR(T0->pos, "Invalid _Static_assert type: %s\n", dbg_type(constant->data_type));
+				ERROR(token_position(T0), "Invalid _Static_assert type: %s\n", dbg_type(constant->data_type));
 
 			if (TACCEPT(T_COMMA)) {
 				if (T0->type != T_STRING)
-					ERROR(T0->pos, "Second argument to _Static_assert must be a string.");
+					ERROR(token_position(T0), "Second argument to _Static_assert must be a string.");
 
-				struct string_view msg = T0->str;
+				struct string_view msg = token_str(T0);
 				TNEXT();
 
 				if (constant->uint_d)
-					ERROR(T0->pos, "Static assert failed: %.*s\n", msg.len, msg.str);
+					ERROR(token_position(T0), "Static assert failed: %.*s\n", msg.len, msg.str);
 			} else {
 				if (constant->uint_d)
-					ERROR(T0->pos, "Static assert failed.\n");
+					ERROR(token_position(T0), "Static assert failed.\n");
 			}
 			TEXPECT(T_RPAR);
 			TEXPECT(T_SEMI_COLON);
@@ -1442,7 +1439,7 @@ int parse_declaration(int external) {
 
 void generate_tentative_definitions(void) {
 	for (size_t i = 0; i < potentially_tentative.size; i++) {
-		struct string_view name = potentially_tentative.names[i];
+		uint32_t name = potentially_tentative.names[i];
 
 		struct symbol_identifier *symbol = symbols_get_identifier_global(name);
 
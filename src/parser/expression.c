@@ -252,7 +252,7 @@ static void cast_conditional(struct expr *expr) {
 			expr->args[2] = expression_cast(expr->args[2], composite);
 			expr->args[1] = expression_cast(expr->args[1], composite);
 		} else {
-			ERROR(T0->pos, "Invalid combination of data types:\n%s and %s\n",
+			ERROR(token_position(T0), "Invalid combination of data types:\n%s and %s\n",
 				  strdup(dbg_type(a)),
 				  strdup(dbg_type(b)));
 		}
@@ -264,7 +264,7 @@ static void cast_conditional(struct expr *expr) {
 			   type_is_arithmetic(b)) {
 		convert_arithmetic(&expr->args[1], &expr->args[2]);
 	} else if (a != b) {
-		ERROR(T0->pos, "Invalid combination of data types:\n%s and %s\n",
+		ERROR(token_position(T0), "Invalid combination of data types:\n%s and %s\n",
 			  strdup(dbg_type(a)),
 			  strdup(dbg_type(b)));
 	}
@@ -388,7 +388,7 @@ static void check_const_correctness(struct expr *expr) {
 
 static struct expr *expr_dot_operator(struct expr *lhs, struct token *name) {
 	int n = 0, *indices;
-	if (!type_search_member(lhs->data_type, name->str, &n, &indices))
+	if (!type_search_member(lhs->data_type, name->spelling, &n, &indices))
 		return NULL;
 
 	for (int i = n - 1; i >= 0; i--) {
@@ -438,7 +438,7 @@ struct expr *expr_new(struct expr expr) {
 		if (!(signature->function.is_variadic ?
 			  named_arguments_count <= expr.call.n_args :
 			  named_arguments_count == expr.call.n_args)) {
-			ERROR(T0->pos, "Wrong number of arguments.");
+			ERROR(token_position(T0), "Wrong number of arguments.");
 		}
 
 		for (int i = named_arguments_count; i < expr.call.n_args; i++) {
@@ -465,9 +465,9 @@ struct expr *expr_new(struct expr expr) {
 	check_const_correctness(&expr);
 
 	if (!expr.pos.path)
-		expr.pos = T0->pos; // If no position is supplied, at least take something close to it.
+		expr.pos = token_position(T0); // If no position is supplied, at least take something close to it.
 
-	return ALLOC(expr);
+	return ARENA_ALLOC(&tu_arena, expr);
 }
 
 // Parsing.
@@ -488,17 +488,17 @@ static void parse_call_parameters(struct expr ***args, int *n_args) {
 		struct expr *expr = parse_assignment_expression();
 
 		if (!expr)
-			ERROR(T0->pos, "Expected expression, got %s", dbg_token(T0));
+			ERROR(token_position(T0), "Expected expression, got %s", dbg_token(T0));
 
 		buffer[pos] = expr;
 	}
 
 	if (pos == MAX_ARGUMENTS)
-		ERROR(T0->pos, "Too many arguments passed to function (maximum: %d)", MAX_ARGUMENTS);
+		ERROR(token_position(T0), "Too many arguments passed to function (maximum: %d)", MAX_ARGUMENTS);
 
 	*args = NULL;
 	if (pos) {
-		*args = cc_malloc(sizeof **args * pos);
+		*args = arena_alloc(&tu_arena, sizeof **args * pos);
 		memcpy(*args, buffer, sizeof **args * pos);
 	}
 
@@ -523,7 +523,7 @@ static struct expr *parse_prefix(void) {
 			} else {
 				struct expr *rhs = parse_pratt(PREFIX_PREC);
 				if (!rhs)
-					ERROR(T0->pos, "Expected expression");
+					ERROR(token_position(T0), "Expected expression");
 				return expression_cast(rhs, cast_type);
 			}
 		} else {
@@ -549,7 +549,7 @@ static struct expr *parse_prefix(void) {
 	} else if (TACCEPT(T_BNOT)) {
 		return EXPR_UNARY_OP(UOP_BNOT, parse_pratt(PREFIX_PREC));
 	} else if (TACCEPT(T_AMP)) {
-		struct position pos = T0->pos;
+		struct position pos = token_position(T0);
 		struct expr *rhs = parse_pratt(PREFIX_PREC);
 		if ((rhs->type == E_VARIABLE && rhs->variable.is_register) ||
 			(rhs->type == E_SYMBOL && rhs->symbol->is_register))
@@ -588,10 +588,10 @@ static struct expr *parse_prefix(void) {
 
 		return type_alignof(type);
 	} else if (T0->type == T_IDENT) {
-		struct symbol_identifier *sym = symbols_get_identifier(T0->str);
+		struct symbol_identifier *sym = symbols_get_identifier(T0->spelling);
 
 		if (!sym)
-			ERROR(T0->pos, "Could not find identifier %.*s", T0->str.len, T0->str.str);
+			ERROR(token_position(T0), "Could not find identifier %.*s", token_str(T0).len, token_str(T0).str);
 
 		TNEXT();
 		switch (sym->type) {
@@ -620,49 +620,49 @@ static struct expr *parse_prefix(void) {
 				});
 		}
 	} else if (T0->type == T_STRING) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_STR(str, ST_CHAR);
 	} else if (T0->type == T_STRING_CHAR16) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_STR(str, CHAR16_TYPE);
 	} else if (T0->type == T_STRING_CHAR32) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_STR(str, CHAR32_TYPE);
 	} else if (T0->type == T_STRING_WCHAR) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_STR(str, abi_info.wchar_type);
 	} else if (T0->type == T_NUM) {
-		struct constant c = constant_from_string(T0->str);
+		struct constant c = constant_from_string(token_str(T0));
 		TNEXT();
 		return expr_new((struct expr) {
 				.type = E_CONSTANT,
 				.constant = c
 			});
 	} else if (T0->type == T_CHARACTER_CONSTANT) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_INT(character_constant_to_int(str));
 	} else if (T0->type == T_CHARACTER_CONSTANT_WCHAR) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_INTEGER(abi_info.wchar_type, character_constant_wchar_to_int(str));
 	} else if (T0->type == T_CHARACTER_CONSTANT_CHAR16) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_INTEGER(CHAR16_TYPE, character_constant_char16_to_int(str));
 	} else if (T0->type == T_CHARACTER_CONSTANT_CHAR32) {
-		struct string_view str = T0->str;
+		struct string_view str = token_str(T0);
 		TNEXT();
 		return EXPR_INTEGER(CHAR32_TYPE, character_constant_char32_to_int(str));
 	} else if (TACCEPT(T_KGENERIC)) {
 		TEXPECT(T_LPAR);
 		struct expr *expr = parse_assignment_expression();
 		if (!expr)
-			ERROR(T0->pos, "Expected expression.");
+			ERROR(token_position(T0), "Expected expression.");
 
 		decay_array(&expr);
 		struct type *match_type = type_make_const(expr->data_type, 0);
@@ -687,7 +687,7 @@ static struct expr *parse_prefix(void) {
 			} else {
 				if (type == match_type) {
 					if (res && !res_is_default)
-						ERROR(T0->pos, "More than one compatible type in _Generic association list, %s",
+						ERROR(token_position(T0), "More than one compatible type in _Generic association list, %s",
 							  strdup(dbg_type(type)));
 					res = rhs;
 				}
@@ -695,7 +695,7 @@ static struct expr *parse_prefix(void) {
 		}
 
 		if (!res)
-			ERROR(T0->pos, "No type matched the expresison in _Generic");
+			ERROR(token_position(T0), "No type matched the expresison in _Generic");
 
 		TEXPECT(T_RPAR);
 		return res;
@@ -734,7 +734,7 @@ static struct expr *parse_prefix(void) {
 		TEXPECT(T_COMMA);
 		struct type *t = parse_type_name();
 		if (!t)
-			ERROR(T0->pos, "Expected typename in var_arg");
+			ERROR(token_position(T0), "Expected typename in var_arg");
 		TEXPECT(T_RPAR);
 		return expr_new((struct expr) {
 				.type = E_BUILTIN_VA_ARG,
@@ -745,7 +745,7 @@ static struct expr *parse_prefix(void) {
 		
 		struct type *type = parse_type_name();
 		if (!type)
-			ERROR(T0->pos, "Expectected type-name.");
+			ERROR(token_position(T0), "Expectected type-name.");
 		TEXPECT(T_COMMA);
 
 		struct expr *expr = expr_new((struct expr) {
@@ -859,12 +859,12 @@ struct expr *parse_pratt_with_lhs(int precedence, struct expr *lhs) {
 		} else if (TACCEPT(T_DOT)) {
 			lhs = expr_dot_operator(lhs, T0);
 			if (!lhs)
-				ERROR(T0->pos, "Could not find member of name %s", dbg_token(T0));
+				ERROR(token_position(T0), "Could not find member of name %s", dbg_token(T0));
 			TNEXT();
 		} else if (TACCEPT(T_ARROW)) {
 			lhs = expr_dot_operator(EXPR_ARGS(E_INDIRECTION, lhs), T0);
 			if (!lhs)
-				ERROR(T0->pos, "Could not find member of name %s", dbg_token(T0));
+				ERROR(token_position(T0), "Could not find member of name %s", dbg_token(T0));
 			TNEXT();
 		} else if (TACCEPT(T_INC)) {
 			lhs = EXPR_ASSIGNMENT_OP(OP_ADD, lhs, EXPR_INT(1), 1);
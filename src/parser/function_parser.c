@@ -26,13 +26,13 @@ static struct function_scope {
 	size_t size, cap;
 
 	struct function_scope_label {
-		struct string_view label;
+		uint32_t label;
 		struct node *block, *end_block;
 		int used;
 	} *labels;
 } function_scope;
 
-static void add_function_scope_label(struct string_view label, struct node *block, struct node *end_block, int used) {
+static void add_function_scope_label(uint32_t label, struct node *block, struct node *end_block, int used) {
 	ADD_ELEMENT(function_scope.size, function_scope.cap, function_scope.labels) =
 		(struct function_scope_label) { label, block, end_block, used };
 }
@@ -49,16 +49,16 @@ int parse_jump_statement(struct jump_blocks *jump_blocks);
 int parse_labeled_statement(struct jump_blocks *jump_blocks) {
 	if (T0->type == T_IDENT &&
 		T1->type == T_COLON) {
-		struct string_view label = T0->str;
+		uint32_t label = T0->spelling;
 		TNEXT();
 		TNEXT();
 
 		struct node *goto_block = 0;
 
 		for (unsigned i = 0; i < function_scope.size; i++) {
-			if (sv_cmp(label, function_scope.labels[i].label)) {
+			if (label == function_scope.labels[i].label) {
 				if (function_scope.labels[i].used)
-					ERROR(T0->pos, "Label declared more than once %.*s", label.len, label.str);
+					ERROR(token_position(T0), "Label declared more than once %s", sv_to_str(intern_str(label)));
 
 				goto_block = function_scope.labels[i].end_block;
 				function_scope.labels[i].used = 1;
@@ -79,15 +79,15 @@ int parse_labeled_statement(struct jump_blocks *jump_blocks) {
 	} else if (TACCEPT(T_KCASE)) {
 		struct expr *value = parse_expression();
 		if (!value)
-			ERROR(T0->pos, "Expected expression");
+			ERROR(token_position(T0), "Expected expression");
 		TEXPECT(T_COLON);
 		struct constant *constant = expression_to_constant(expression_cast(value, type_simple(ST_INT)));
 		if (!constant)
-			ERROR(T0->pos, "Expression not constant, is of type %d", value->type);
+			ERROR(token_position(T0), "Expression not constant, is of type %d", value->type);
 
 		struct node *case_control = jump_blocks->case_control;
 		if (!case_control)
-			ERROR(T0->pos, "Not currently in a switch statement");
+			ERROR(token_position(T0), "Not currently in a switch statement");
 
 		struct node *block_case = new_block(),
 			*new_entry = new_block();
@@ -115,7 +115,7 @@ int parse_labeled_statement(struct jump_blocks *jump_blocks) {
 		ir_goto(block_default);
 		ir_block_start(block_default);
 		if (!jump_blocks->block_entry)
-			ERROR(T0->pos, "Not currently in a switch statement");
+			ERROR(token_position(T0), "Not currently in a switch statement");
 		jump_blocks->block_default = block_default;
 
 		parse_statement(jump_blocks);
@@ -153,7 +153,7 @@ static int parse_switch(struct jump_blocks *jump_blocks) {
 	struct expr *condition = parse_expression();
 
 	if (!condition)
-		ERROR(T0->pos, "Expected expression");
+		ERROR(token_position(T0), "Expected expression");
 
 	struct node *case_control = expression_to_int(condition);
 
@@ -193,7 +193,7 @@ int parse_selection_statement(struct jump_blocks *jump_blocks) {
 		TEXPECT(T_LPAR);
 		struct expr *expr = parse_expression();
 		if(!expr)
-			ERROR(T0->pos, "Expected expression in if condition");
+			ERROR(token_position(T0), "Expected expression in if condition");
 
 		struct node *condition = expression_to_ir(expr);
 
@@ -255,7 +255,7 @@ static int parse_do_while_statement(struct jump_blocks *jump_blocks) {
 
 	struct expr *control_expression = parse_expression();
 	if (!control_expression)
-		ERROR(T0->pos, "Expected expression");
+		ERROR(token_position(T0), "Expected expression");
 
 	struct node *control_variable = expression_to_int(control_expression);
 
@@ -297,7 +297,7 @@ static int parse_while_statement(struct jump_blocks *jump_blocks) {
 
 	struct expr *control_expression = parse_expression();
 	if (!control_expression)
-		ERROR(T0->pos, "Expected expression");
+		ERROR(token_position(T0), "Expected expression");
 
 	TEXPECT(T_RPAR);
 
@@ -361,7 +361,7 @@ static int parse_for_statement(struct jump_blocks *jump_blocks) {
 	if (!(TACCEPT(T_SEMI_COLON) ||
 		  parse_declaration(0) ||
 		  parse_expression_statement()))
-		ERROR(T0->pos, "Invalid first part of for loop");
+		ERROR(token_position(T0), "Invalid first part of for loop");
 
 	ir_goto(block_control);
 	ir_block_start(block_control);
@@ -417,11 +417,11 @@ struct type *current_ret_val = NULL;
 
 int parse_jump_statement(struct jump_blocks *jump_blocks) {
 	if (TACCEPT(T_KGOTO)) {
-		struct string_view label = T0->str;
+		uint32_t label = T0->spelling;
 		TNEXT();
 		TEXPECT(T_SEMI_COLON);
 		for (unsigned i = 0; i < function_scope.size; i++) {
-			if (sv_cmp(label, function_scope.labels[i].label)) {
+			if (label == function_scope.labels[i].label) {
 				// Necessary to avoid more than 2 predecessors
 				// to each block.
 				struct node *step = new_block();
@@ -490,13 +490,13 @@ int parse_statement(struct jump_blocks *jump_blocks) {
 		TACCEPT(T_SEMI_COLON);
 }
 
-static struct string_view current_function = { 0 };
+static uint32_t current_function = 0;
 
 struct string_view get_current_function_name(void) {
-	return current_function;
+	return intern_str(current_function);
 }
 
-void parse_function(struct string_view name, struct type *type, int arg_n, struct symbol_identifier **args, int global) {
+void parse_function(uint32_t name, struct type *type, int arg_n, struct symbol_identifier **args, int global) {
 	(void)arg_n;
 	current_function = name;
 	struct symbol_identifier *symbol = symbols_get_identifier_global(name);
@@ -514,7 +514,7 @@ void parse_function(struct string_view name, struct type *type, int arg_n, struc
 
 	assert(type->type == TY_FUNCTION);
 
-	struct node *func = new_function(sv_to_str(name), global);
+	struct node *func = new_function(sv_to_str(intern_str(name)), global);
 	abi_expr_function(func, type, args);
 
 	type_evaluate_vla(type);
@@ -522,7 +522,7 @@ void parse_function(struct string_view name, struct type *type, int arg_n, struc
 	struct jump_blocks jump_blocks = { 0 };
 	parse_compound_statement(&jump_blocks);
 
-	if (sv_string_cmp(name, "main")) {
+	if (sv_string_cmp(intern_str(name), "main")) {
 		struct node *b = get_current_block();
 		if (!b->block_info.end) {
 			struct node *reg_state = NULL;
@@ -537,4 +537,6 @@ void parse_function(struct string_view name, struct type *type, int arg_n, struc
 	}
 	
 	symbols_pop_scope();
+
+	parser_function_parsed();
 }
@@ -4,7 +4,7 @@
 #include "parser.h"
 #include "parser/symbols.h"
 
-void parse_function(struct string_view name, struct type *type, int arg_n, struct symbol_identifier **args, int global);
+void parse_function(uint32_t name, struct type *type, int arg_n, struct symbol_identifier **args, int global);
 struct string_view get_current_function_name(void);
 
 #endif
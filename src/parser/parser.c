@@ -4,6 +4,7 @@
 #include "symbols.h"
 
 #include <common.h>
+#include <types.h>
 #include <preprocessor/preprocessor.h>
 
 #include <stdlib.h>
@@ -14,6 +15,8 @@ static size_t pack_size, pack_cap;
 static int *packs;
 static int current_packing;
 
+static function_callback on_function;
+
 int get_current_packing(void) {
 	return current_packing;
 }
@@ -22,20 +25,23 @@ void parser_reset(void) {
 	pack_size = pack_cap = 0;
 	current_packing = 0;
 	free(packs);
+	packs = NULL;
 	symbols_reset();
+	types_reset();
+	arena_reset(&tu_arena);
 }
 
 int parse_handle_pragma(void) {
 	if (!TACCEPT(PP_DIRECTIVE))
 		return 0;
-	assert(sv_string_cmp(T0->str, "pragma"));
+	assert(sv_string_cmp(token_str(T0), "pragma"));
 
 	TNEXT();
 
 	if (T0->type != T_IDENT)
-		ERROR(T0->pos, "Expected identifier\n");
+		ERROR(token_position(T0), "Expected identifier\n");
 
-	struct string_view name = T0->str;
+	struct string_view name = token_str(T0);
 
 	if (sv_string_cmp(name, "pack")) {
 		int new_packing = 0;
@@ -43,13 +49,13 @@ int parse_handle_pragma(void) {
 		TEXPECT(T_LPAR);
 
 		if (T0->type == T_IDENT) {
-			if (sv_string_cmp(T0->str, "pop")) {
+			if (sv_string_cmp(token_str(T0), "pop")) {
 				if (pack_size)
 					pack_size--;
 				TNEXT();
 				TEXPECT(T_RPAR);
 				return 1;
-			} else if (sv_string_cmp(T0->str, "push")) {
+			} else if (sv_string_cmp(token_str(T0), "push")) {
 				ADD_ELEMENT(pack_size, pack_cap, packs) = current_packing;
 				TNEXT();
 
@@ -63,9 +69,9 @@ int parse_handle_pragma(void) {
 		}
 
 		if (T0->type == T_NUM) {
-			struct constant c = constant_from_string(T0->str);
+			struct constant c = constant_from_string(token_str(T0));
 			if (!type_is_integer(c.data_type))
-				ERROR(T0->pos, "Packing must be integer.");
+				ERROR(token_position(T0), "Packing must be integer.");
 
 			new_packing = is_signed(c.data_type->simple) ? (intmax_t)c.int_d : (intmax_t)c.uint_d;
 			TNEXT();
@@ -75,7 +81,7 @@ int parse_handle_pragma(void) {
 
 		current_packing = new_packing;
 	} else {
-		WARNING(T0->pos, "\"#pragma %.*s\" not supported", name.len, name.str);
+		WARNING(token_position(T0), "\"#pragma %.*s\" not supported", name.len, name.str);
 
 		// Continue until newline or EOI.
 		while (T0->type != T_EOI &&
@@ -86,11 +92,23 @@ int parse_handle_pragma(void) {
 	return 1;
 }
 
-void parse_into_ir(void) {
+void parser_function_parsed(void) {
+	if (!on_function)
+		return;
+
+	ir_seal_blocks();
+	on_function();
+}
+
+void parse_into_ir(function_callback callback) {
+	on_function = callback;
+
 	while (parse_declaration(1) || TACCEPT(T_SEMI_COLON) || parse_handle_pragma());
 
 	TEXPECT(T_EOI);
 
 	generate_tentative_definitions();
 	ir_seal_blocks();
+
+	on_function = NULL;
 }
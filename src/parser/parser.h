@@ -3,7 +3,13 @@
 
 #include <ir/ir.h>
 
-void parse_into_ir(void);
+// Called after the IR of each function definition is complete, with its
+// blocks sealed. It can generate code for the function and release the IR.
+typedef void (*function_callback)(void);
+
+// Without a callback, the IR of all functions is kept until the end.
+void parse_into_ir(function_callback on_function);
+void parser_function_parsed(void);
 void parser_reset(void);
 
 extern struct parser_flags parser_flags;
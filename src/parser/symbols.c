@@ -8,6 +8,9 @@
 // https://www.ida.liu.se/~TDDB44/lectures/PDF-OH2006/Symboltable-2008.pdf
 // The performance improvement was quite modest, but it still feels like
 // the correct design.
+// Entries of file scope are kept in their own table, so adding a global
+// while inside blocks never moves the entries of the blocks. The entries of
+// blocks are in the order of their blocks, and popped from the end.
 
 struct entry_id {
 	enum entry_type {
@@ -15,7 +18,7 @@ struct entry_id {
 		ENTRY_STRUCT,
 		ENTRY_IDENTIFIER
 	} type;
-	struct string_view name;
+	uint32_t name;
 };
 
 struct table_entry {
@@ -30,173 +33,147 @@ struct table_entry {
 	int block, link;
 };
 
-static struct hash_table {
-	int size;
-	int *entries;
-} hash_table;
-
+// Each hash chain starts with the newest entry.
 static struct table {
 	size_t size, cap;
 	struct table_entry *entries;
-} table;
+
+	size_t n_heads; // Power of two, at least size.
+	int *heads;
+} global_table, block_table;
 
 static int current_block = 0;
 
 static uint32_t hash_entry(struct entry_id id) {
-	return hash32(id.type) ^ sv_hash(id.name);
+	return hash32(id.type) ^ intern_hash(id.name);
 }
 
 static int compare_entry(struct entry_id a, struct entry_id b) {
-	return a.type == b.type && sv_cmp(a.name, b.name);
-}
-
-void symbols_push_scope(void) {
-	current_block++;
+	return a.type == b.type && a.name == b.name;
 }
 
-void symbols_pop_scope(void) {
-	current_block--;
-	for (int i = table.size - 1; i >= 0; i--) {
-		struct table_entry *entry = table.entries + i;
-		if (entry->block <= current_block)
-			break;
+static void table_rehash(struct table *table, size_t n_heads) {
+	free(table->heads);
+	table->n_heads = n_heads;
+	table->heads = cc_malloc(sizeof *table->heads * n_heads);
+	for (size_t i = 0; i < n_heads; i++)
+		table->heads[i] = -1;
 
-		uint32_t hash = hash_entry(entry->id) % hash_table.size;
-
-		hash_table.entries[hash] = entry->link;
-		table.size = i;
+	for (size_t i = 0; i < table->size; i++) {
+		struct table_entry *entry = table->entries + i;
+		uint32_t hash = hash_entry(entry->id) & (n_heads - 1);
+		entry->link = table->heads[hash];
+		table->heads[hash] = i;
 	}
 }
 
-static struct table_entry *get_entry(struct entry_id id, int global) {
-	uint32_t hash = hash_entry(id) % hash_table.size;
-	int current_idx = hash_table.entries[hash];
+static struct table_entry *table_get(struct table *table, struct entry_id id) {
+	int current_idx = table->heads[hash_entry(id) & (table->n_heads - 1)];
 
 	while (current_idx >= 0) {
-		struct table_entry *entry = table.entries + current_idx;
-		if (compare_entry(entry->id, id) &&
-			!(global && entry->block != 0)) {
+		struct table_entry *entry = table->entries + current_idx;
+		if (compare_entry(entry->id, id))
 			return entry;
-		}
 		current_idx = entry->link;
 	}
 
 	return NULL;
 }
 
-static struct table_entry *add_entry_with_block(struct entry_id id, int block) {
-	// Move entire table one step down for entry->block > block.
-	(void)ADD_ELEMENT(table.size, table.cap, table.entries);
+static struct table_entry *table_add(struct table *table, struct entry_id id, int block) {
+	if (table->size + 1 > table->n_heads)
+		table_rehash(table, table->n_heads * 2);
 
-	int i;
-	for (i = table.size - 2; i >= 0; i--) {
-		struct table_entry *entry = table.entries + i;
-		if (entry->block > block) {
-			uint32_t hash = hash_entry(entry->id) % hash_table.size;
+	uint32_t hash = hash_entry(id) & (table->n_heads - 1);
 
-			if (hash_table.entries[hash] == i)
-				hash_table.entries[hash]++;
+	struct table_entry *new_entry = &ADD_ELEMENT(table->size, table->cap, table->entries);
 
-			if (entry->link >= 0 && table.entries[entry->link].block > block) {
-				entry->link++;
-			}
-
-			table.entries[i + 1] = *entry;
-		} else {
-			break;
-		}
-	}
-	i++;
-
-	uint32_t hash = hash_entry(id) % hash_table.size;
-	int *link = &hash_table.entries[hash];
-	while (*link >= 0 && *link > i) {
-		struct table_entry *entry = table.entries + *link;
-		link = &entry->link;
-	}
-
-	table.entries[i] = (struct table_entry) {
+	*new_entry = (struct table_entry) {
 		.id.name = id.name,
 		.id.type = id.type,
 		.block = block,
-		.link = *link,
+		.link = table->heads[hash],
 	};
 
-	*link = i;
+	table->heads[hash] = table->size - 1;
 
-	return table.entries + i;
+	return new_entry;
 }
 
-static struct table_entry *add_entry(struct entry_id id) {
-	uint32_t hash = hash_entry(id) % hash_table.size;
-
-	struct table_entry *new_entry = &ADD_ELEMENT(table.size, table.cap, table.entries);
+void symbols_push_scope(void) {
+	current_block++;
+}
 
-	*new_entry = (struct table_entry) {
-		.id.name = id.name,
-		.id.type = id.type,
-		.block = current_block,
-		.link = hash_table.entries[hash],
-	};
+void symbols_pop_scope(void) {
+	current_block--;
+	while (block_table.size && block_table.entries[block_table.size - 1].block > current_block) {
+		struct table_entry *entry = block_table.entries + --block_table.size;
+		block_table.heads[hash_entry(entry->id) & (block_table.n_heads - 1)] = entry->link;
+	}
+}
 
-	hash_table.entries[hash] = table.size - 1;
+static struct table_entry *get_entry(struct entry_id id, int global) {
+	struct table_entry *entry = global ? NULL : table_get(&block_table, id);
+	return entry ? entry : table_get(&global_table, id);
+}
 
-	return new_entry;
+static struct table_entry *add_entry(struct entry_id id) {
+	return table_add(current_block ? &block_table : &global_table, id, current_block);
 }
 
 // table_entry querying.
-static struct table_entry *symbols_add(enum entry_type type, struct string_view name) {
+static struct table_entry *symbols_add(enum entry_type type, uint32_t name) {
 	struct table_entry *entry = get_entry((struct entry_id) { type, name }, 0);
 
 	if (entry && entry->block == current_block)
-		ICE("Name already declared, %.*s", name.len, name.str);
+		ICE("Name already declared, %s", sv_to_str(intern_str(name)));
 
 	return add_entry((struct entry_id) { type, name });
 }
 
-static struct table_entry *symbols_get(enum entry_type type, struct string_view name) {
+static struct table_entry *symbols_get(enum entry_type type, uint32_t name) {
 	return get_entry((struct entry_id) { type, name }, 0);
 }
 
-static struct table_entry *symbols_get_in_current_scope(enum entry_type type, struct string_view name) {
+static struct table_entry *symbols_get_in_current_scope(enum entry_type type, uint32_t name) {
 	struct table_entry *entry = get_entry((struct entry_id) { type, name }, 0);
 
 	return (entry && entry->block == current_block) ? entry : NULL;
 }
 
 // Identifier help functions.
-struct symbol_identifier *symbols_add_identifier(struct string_view name) {
-	if (name.len == 0) {
+struct symbol_identifier *symbols_add_identifier(uint32_t name) {
+	if (!name) {
 		// Anonymous identifier.
-		return ALLOC((struct symbol_identifier) { 0 });
+		return ARENA_ALLOC(&tu_arena, (struct symbol_identifier) { 0 });
 	}
 	struct table_entry *entry = symbols_add(ENTRY_IDENTIFIER, name);
-	entry->identifier_data = ALLOC((struct symbol_identifier) { 0 });
+	entry->identifier_data = ARENA_ALLOC(&tu_arena, (struct symbol_identifier) { 0 });
 	return entry->identifier_data;
 }
 
-struct symbol_identifier *symbols_get_identifier(struct string_view name) {
+struct symbol_identifier *symbols_get_identifier(uint32_t name) {
 	struct table_entry *entry = symbols_get(ENTRY_IDENTIFIER, name);
 	return entry ? entry->identifier_data : NULL;
 }
 
-struct symbol_identifier *symbols_get_identifier_in_current_scope(struct string_view name) {
+struct symbol_identifier *symbols_get_identifier_in_current_scope(uint32_t name) {
 	struct table_entry *entry = symbols_get_in_current_scope(ENTRY_IDENTIFIER, name);
 	return entry ? entry->identifier_data : NULL;
 }
 
-struct symbol_identifier *symbols_add_identifier_global(struct string_view name) {
+struct symbol_identifier *symbols_add_identifier_global(uint32_t name) {
 	struct table_entry *entry = get_entry((struct entry_id) { ENTRY_IDENTIFIER, name }, 1);
 
 	if (entry && entry->block == current_block)
-		ICE("Name already declared, %.*s", name.len, name.str);
+		ICE("Name already declared, %s", sv_to_str(intern_str(name)));
 
-	entry = add_entry_with_block((struct entry_id) { ENTRY_IDENTIFIER, name }, 0);
-	entry->identifier_data = ALLOC((struct symbol_identifier) { 0 });
+	entry = table_add(&global_table, (struct entry_id) { ENTRY_IDENTIFIER, name }, 0);
+	entry->identifier_data = ARENA_ALLOC(&tu_arena, (struct symbol_identifier) { 0 });
 	return entry->identifier_data;
 }
 
-struct symbol_identifier *symbols_get_identifier_global(struct string_view name) {
+struct symbol_identifier *symbols_get_identifier_global(uint32_t name) {
 	struct table_entry *entry = get_entry((struct entry_id) { ENTRY_IDENTIFIER, name }, 1);
 	return entry ? entry->identifier_data : NULL;
 }
@@ -212,22 +189,22 @@ struct type *symbols_get_identifier_type(struct symbol_identifier *symbol) {
 }
 
 // Struct help functions.
-struct symbol_struct *symbols_add_struct(struct string_view name) {
+struct symbol_struct *symbols_add_struct(uint32_t name) {
 	return &symbols_add(ENTRY_STRUCT, name)->struct_data;
 }
 
-struct symbol_struct *symbols_get_struct(struct string_view name) {
+struct symbol_struct *symbols_get_struct(uint32_t name) {
 	struct table_entry *entry = symbols_get(ENTRY_STRUCT, name);
 	return entry ? &entry->struct_data : NULL;
 }
 
-struct symbol_struct *symbols_get_struct_in_current_scope(struct string_view name) {
+struct symbol_struct *symbols_get_struct_in_current_scope(uint32_t name) {
 	struct table_entry *entry = symbols_get_in_current_scope(ENTRY_STRUCT, name);
 	return entry ? &entry->struct_data : NULL;
 }
 
 // Typedef help functions.
-struct symbol_typedef *symbols_add_typedef(struct string_view name) {
+struct symbol_typedef *symbols_add_typedef(uint32_t name) {
 	struct entry_id id = {ENTRY_TYPEDEF, name};
 	struct table_entry *entry = get_entry(id, 0);
 
@@ -237,25 +214,26 @@ struct symbol_typedef *symbols_add_typedef(struct string_view name) {
 	return &add_entry(id)->typedef_data;
 }
 
-struct symbol_typedef *symbols_get_typedef(struct string_view name) {
+struct symbol_typedef *symbols_get_typedef(uint32_t name) {
 	struct table_entry *entry = symbols_get(ENTRY_TYPEDEF, name);
 	return entry ? &entry->typedef_data : NULL;
 }
 
 // Init everything. Called from main.
 void symbols_init(void) {
-	hash_table.size = 1024;
-	hash_table.entries = cc_malloc(sizeof *hash_table.entries * hash_table.size);
-	for (int i = 0; i < hash_table.size; i++)
-		hash_table.entries[i] = -1;
+	table_rehash(&global_table, 1024);
+	table_rehash(&block_table, 1024);
 }
 
-void symbols_reset(void) {
-	free(hash_table.entries);
-	hash_table = (struct hash_table) { 0 };
+static void table_free(struct table *table) {
+	free(table->heads);
+	free(table->entries);
+	*table = (struct table) { 0 };
+}
 
-	free(table.entries);
-	table = (struct table) { 0 };
+void symbols_reset(void) {
+	table_free(&global_table);
+	table_free(&block_table);
 
 	current_block = 0;
 }
@@ -3,11 +3,12 @@
 
 #include "parser.h"
 
-#include <string_view.h>
+#include <intern.h>
 
 // This is the symbol table used in the compiler.
 // It holds variables (including functions), structs/unions, and typedefs.
 // These three have different namespaces, but the same scoping rules.
+// Names are interned ids, see intern.h. Id 0 is an anonymous identifier.
 
 // The pre-processor has its own symbol table, since it does not follow the same
 // scoping rules.
@@ -36,7 +37,7 @@ struct symbol_identifier {
 		} variable;
 		struct {
 			struct type *type;
-			struct string_view name;
+			uint32_t name;
 		} label;
 	};
 
@@ -47,12 +48,12 @@ struct symbol_identifier {
 
 struct type *symbols_get_identifier_type(struct symbol_identifier *symbol);
 
-struct symbol_identifier *symbols_add_identifier_global(struct string_view name);
-struct symbol_identifier *symbols_get_identifier_global(struct string_view name);
+struct symbol_identifier *symbols_add_identifier_global(uint32_t name);
+struct symbol_identifier *symbols_get_identifier_global(uint32_t name);
 
-struct symbol_identifier *symbols_add_identifier(struct string_view name);
-struct symbol_identifier *symbols_get_identifier(struct string_view);
-struct symbol_identifier *symbols_get_identifier_in_current_scope(struct string_view name);
+struct symbol_identifier *symbols_add_identifier(uint32_t name);
+struct symbol_identifier *symbols_get_identifier(uint32_t name);
+struct symbol_identifier *symbols_get_identifier_in_current_scope(uint32_t name);
 
 struct symbol_struct {
 	enum {
@@ -65,15 +66,15 @@ struct symbol_struct {
 	struct enum_data *enum_data;
 };
 
-struct symbol_struct *symbols_add_struct(struct string_view name);
-struct symbol_struct *symbols_get_struct(struct string_view name);
-struct symbol_struct *symbols_get_struct_in_current_scope(struct string_view name);
+struct symbol_struct *symbols_add_struct(uint32_t name);
+struct symbol_struct *symbols_get_struct(uint32_t name);
+struct symbol_struct *symbols_get_struct_in_current_scope(uint32_t name);
 
 struct symbol_typedef {
 	struct type *data_type;
 };
 
-struct symbol_typedef *symbols_add_typedef(struct string_view name);
-struct symbol_typedef *symbols_get_typedef(struct string_view name);
+struct symbol_typedef *symbols_add_typedef(uint32_t name);
+struct symbol_typedef *symbols_get_typedef(uint32_t name);
 
 #endif
@@ -4,19 +4,33 @@
 #include "string_concat.h"
 
 #include <common.h>
+#include <escape_sequence.h>
 #include <precedence.h>
 #include <arch/x64.h>
 
 #include <assert.h>
 
+// Include guard detection, following the tokens of a file as they are read.
+enum {
+	GUARD_START, // Expecting #ifndef X.
+	GUARD_OPEN, // Inside #ifndef X.
+	GUARD_CLOSED, // After the matching #endif.
+	GUARD_NONE,
+};
+
 struct tokenized_file {
-	int token_idx;
-	struct token_list tokens;
+	struct tokenizer tokenizer;
 
 	int pushed_idx;
 	struct token pushed[3];
 
+	int guard_state, guard_depth, guard_pos;
+	ttype guard_prev_type;
+	uint32_t guard;
+
 	const char *path;
+	int file;
+	int system; // In a system include path, or included from such a file.
 	struct tokenized_file *parent;
 };
 
@@ -33,7 +47,7 @@ struct macro_stack {
 static size_t macro_stack_size, macro_stack_cap;
 static struct macro_stack *macro_stacks;
 
-static int write_dependencies = 0;
+static int write_dependencies = 0, skip_system_dependencies = 0;
 static size_t dep_size, dep_cap;
 static char **deps;
 
@@ -41,17 +55,38 @@ void directiver_write_dependencies(void) {
 	write_dependencies = 1;
 }
 
-void directiver_finish_writing_dependencies(const char *mt, const char *mf) {
-	write_dependencies = 1;
-
-	FILE *fp = fopen(mf, "w");
+void directiver_skip_system_dependencies(void) {
+	skip_system_dependencies = 1;
+}
 
+void directiver_print_dependencies(FILE *fp, const char *mt) {
 	fprintf(fp, "%s:", mt);
 	for (unsigned i = 0; i < dep_size; i++)
 		fprintf(fp, " %s", deps[i]);
 	fprintf(fp, "\n");
+}
 
-	fclose(fp);
+void directiver_finish_writing_dependencies(const char *mt, const char *mf) {
+	write_dependencies = 1;
+
+	FILE *fp = mf ? fopen(mf, "w") : stdout;
+	if (!fp)
+		ERROR_NO_POS("Could not open %s", mf);
+
+	directiver_print_dependencies(fp, mt);
+
+	if (mf)
+		fclose(fp);
+}
+
+char **directiver_get_dependencies(size_t *n) {
+	*n = dep_size;
+	return deps;
+}
+
+void directiver_add_dependency(const char *path) {
+	if (write_dependencies)
+		ADD_ELEMENT(dep_size, dep_cap, deps) = strdup(path);
 }
 
 // Resets all global state. Not very elegant.
@@ -71,38 +106,95 @@ void directiver_reset(void) {
 	deps = NULL;
 }
 
-void directiver_push_input(const char *path, int system) {
+// The file is guarded if it has the form #ifndef X ... #endif, with nothing
+// outside the conditional. Including the file again while X is defined
+// has no effect.
+static void follow_include_guard(struct tokenized_file *file, struct token t) {
+	struct string_view name = { 0 };
+	if (file->guard_prev_type == PP_DIRECTIVE && t.type == T_IDENT && !t.first_of_line)
+		name = token_str(&t);
+	file->guard_prev_type = t.type;
+	int pos = file->guard_pos++;
+
+	switch (file->guard_state) {
+	case GUARD_START:
+		if (pos == 0 && t.type == PP_DIRECTIVE) {
+		} else if (pos == 1 && sv_string_cmp(name, "ifndef")) {
+		} else if (pos == 2 && t.type == T_IDENT && !t.first_of_line && t.first_of_line_after) {
+			file->guard = t.spelling;
+			file->guard_depth = 1;
+			file->guard_state = GUARD_OPEN;
+		} else {
+			file->guard_state = GUARD_NONE;
+		}
+		break;
+
+	case GUARD_OPEN:
+		if (sv_string_cmp(name, "if") ||
+			sv_string_cmp(name, "ifdef") ||
+			sv_string_cmp(name, "ifndef")) {
+			file->guard_depth++;
+		} else if (sv_string_cmp(name, "endif")) {
+			if (--file->guard_depth == 0)
+				file->guard_state = GUARD_CLOSED;
+		} else if (file->guard_depth == 1 &&
+				   (sv_string_cmp(name, "else") ||
+					sv_string_cmp(name, "elif") ||
+					sv_string_cmp(name, "elifdef") ||
+					sv_string_cmp(name, "elifndef"))) {
+			file->guard_state = GUARD_NONE;
+		}
+		break;
+
+	case GUARD_CLOSED:
+		file->guard_state = GUARD_NONE;
+		break;
+	}
+}
+
+void directiver_push_input(const char *path, int angled) {
 	const char *parent_path = current_file ? current_file->path : ".";
-	struct input new_input = input_open(parent_path, path, system);
+	struct input new_input = input_open(parent_path, path, angled);
 
 	if (!new_input.path)
 		return;
 
-	if (write_dependencies)
-		ADD_ELEMENT(dep_size, dep_cap, deps) = strdup(new_input.path);
+	int system = new_input.system || (current_file && current_file->system);
 
-	current_file = ALLOC((struct tokenized_file) {
+	if (!(system && skip_system_dependencies))
+		directiver_add_dependency(new_input.path);
+
+	current_file = ARENA_ALLOC(&preprocessor_arena, (struct tokenized_file) {
 			.parent = current_file,
-			.token_idx = 0,
-			.tokens = tokenize_input(new_input.contents, new_input.path),
-			.path = strdup(new_input.path),
+			.path = new_input.path,
+			.file = new_input.file,
+			.system = system,
 		});
+
+	tokenizer_init(&current_file->tokenizer, new_input.contents, new_input.path);
 }
 
 static struct token next(void);
 
 static struct token next_from_stack(void) {
-	if (current_file->token_idx == current_file->tokens.size) {
-		if (current_file->parent) {
-			token_list_free(&current_file->tokens);
-			current_file = current_file->parent;
-			return next();
-		}
+	struct token t = tokenizer_next(&current_file->tokenizer);
 
-		return (struct token ) { .type = T_EOI };
+	if (t.type != T_EOI) {
+		if (current_file->guard_state != GUARD_NONE)
+			follow_include_guard(current_file, t);
+		return t;
 	}
 
-	return current_file->tokens.list[current_file->token_idx++];
+	if (current_file->guard_state == GUARD_CLOSED)
+		input_set_guard(current_file->file, current_file->guard);
+
+	if (current_file->parent) {
+		current_file = current_file->parent;
+		return next();
+	}
+
+	// Ends any directive on the last line.
+	return (struct token) { .type = T_EOI, .first_of_line = 1 };
 }
 
 static void push(struct token t) {
@@ -119,16 +211,16 @@ static struct token next(void) {
 	} else {
 		t = next_from_stack();
 	}
-	t.pos.line += line_diff;
-	if (new_path)
-		t.pos.path = new_path;
+	if (line_diff || new_path)
+		t.loc = location_remap(t.loc, new_path, line_diff);
 	return t;
 }
 
 static void directiver_define(void) {
 	struct token name = next();
 
-	struct define def = define_init(name.str);
+	struct define def = define_init(name.spelling);
+	def.loc = name.loc;
 
 	struct token t = next();
 	if(t.type == T_LPAR && !t.whitespace) {
@@ -175,11 +267,11 @@ static int buffer_pos;
 
 static struct token buffer_next(void) {
 	if (buffer_pos >= buffer.size)
-		return (struct token) { .type = T_EOI, .str = { 0 } };
+		return (struct token) { .type = T_EOI };
 	struct token *t = buffer.list + buffer_pos;
 	if (t->type == T_IDENT) {
 		buffer_pos++;
-		return (struct token) { .type = T_NUM, .str = sv_from_str("0") };
+		return (struct token) { .type = T_NUM, .spelling = intern(sv_from_str("0")) };
 	} else {
 		return buffer.list[buffer_pos++];
 	}
@@ -208,9 +300,9 @@ int result_is_zero(struct result result) {
 void check_div_overflow(struct token *t,
 						struct result lhs, struct result rhs) {
 	if (result_is_zero(rhs))
-		ERROR(t->pos, "Division by zero");
+		ERROR(token_position(t), "Division by zero");
 	if (lhs.is_signed && lhs.i == INTMAX_MIN && rhs.i == -1)
-		ERROR(t->pos, "Division will overflow");
+		ERROR(token_position(t), "Division will overflow");
 }
 
 #define RESULT_UNARY(OP, EXPR) ((EXPR).is_signed				\
@@ -243,14 +335,14 @@ static struct result evaluate_expression(int prec, int evaluate) {
 		expr = evaluate_expression(0, evaluate);
 		struct token rpar = buffer_next();
 		if (rpar.type != T_RPAR)
-			ERROR(rpar.pos, "Expected ), got %s", dbg_token_type(rpar.type));
+			ERROR(token_position(&rpar), "Expected ), got %s", dbg_token_type(rpar.type));
 	} else if (t.type == T_NUM) {
-		struct constant c = constant_from_string(t.str);
+		struct constant c = constant_from_string(token_str(&t));
 		assert(c.type == CONSTANT_TYPE);
 		if (type_is_floating(c.data_type))
-			ERROR(t.pos, "Floating point arithmetic in the preprocessor is not allowed.");
+			ERROR(token_position(&t), "Floating point arithmetic in the preprocessor is not allowed.");
 		if (!type_is_integer(c.data_type))
-			ERROR(t.pos, "Preprocessor variables must be of integer type.");
+			ERROR(token_position(&t), "Preprocessor variables must be of integer type.");
 		if (is_signed(c.data_type->simple))
 			expr = result_signed(c.int_d);
 		else
@@ -258,7 +350,7 @@ static struct result evaluate_expression(int prec, int evaluate) {
 	} else if (t.type == T_CHARACTER_CONSTANT) {
 		expr = result_signed(escaped_character_constant_to_int(t));
 	} else {
-		ERROR(t.pos, "Invalid token in preprocessor expression. %s", dbg_token(&t));
+		ERROR(token_position(&t), "Invalid token in preprocessor expression. %s", dbg_token(&t));
 	}
 
 	t = buffer_next();
@@ -313,7 +405,7 @@ static struct result evaluate_expression(int prec, int evaluate) {
 					expr = RESULT_BINARY(%, expr, rhs);
 					break;
 				default:
-					ERROR(t.pos, "Invalid infix %s", dbg_token(&t));
+					ERROR(token_position(&t), "Invalid infix %s", dbg_token(&t));
 				}
 			}
 		}
@@ -332,15 +424,15 @@ static struct result evaluate_until_newline(void) {
 	buffer.size = 0;
 	struct token t = next();
 	while (!t.first_of_line) {
-		if (sv_string_cmp(t.str, "defined")) {
+		if (sv_string_cmp(token_str(&t), "defined")) {
 			t = next();
 			int has_lpar = t.type == T_LPAR;
 			if (has_lpar)
 				t = next();
 
-			int is_defined = define_map_get(t.str) != NULL;
-			token_list_add(&buffer, (struct token) {.type = T_NUM, .str = is_defined ? sv_from_str("1") :
-					sv_from_str("0")});
+			int is_defined = define_map_get(t.spelling) != NULL;
+			token_list_add(&buffer, (struct token) {.type = T_NUM, .spelling = intern(is_defined ? sv_from_str("1") :
+					sv_from_str("0"))});
 
 			t = next();
 
@@ -363,7 +455,7 @@ static struct result evaluate_until_newline(void) {
 	return evaluate_expression(0, 1);
 }
 
-static struct string_view get_include_path(struct token dir, struct token t, int *system) {
+static struct string_view get_include_path(struct token dir, struct token t, int *angled) {
 	buffer.size = 0;
 	while (!t.first_of_line) {
 		token_list_add(&buffer, t);
@@ -374,11 +466,11 @@ static struct string_view get_include_path(struct token dir, struct token t, int
 	expand_token_list(&buffer);
 
 	if (buffer.size != 1 || buffer.list[0].type != T_STRING)
-		ERROR(dir.pos, "Invalidly formatted path to #include directive.");
+		ERROR(token_position(&dir), "Invalidly formatted path to #include directive.");
 
-	*system = 0;
+	*angled = 0;
 
-	struct string_view path = buffer.list[0].str;
+	struct string_view path = token_str(&buffer.list[0]);
 	path.len -= 2;
 	path.str++;
 
@@ -386,28 +478,33 @@ static struct string_view get_include_path(struct token dir, struct token t, int
 	return path;
 }
 
+static uint32_t next_spelling(void) {
+	return next().spelling;
+}
+
 static int directiver_evaluate_conditional(struct token dir) {
-	if (sv_string_cmp(dir.str, "ifdef") ||
-		sv_string_cmp(dir.str, "elifdef")) {
-		return (define_map_get(next().str) != NULL);
-	} else if (sv_string_cmp(dir.str, "ifndef") ||
-			   sv_string_cmp(dir.str, "elifndef")) {
-		return !(define_map_get(next().str) != NULL);
-	} else if (sv_string_cmp(dir.str, "if") ||
-			   sv_string_cmp(dir.str, "elif")) {
+	struct string_view name = token_str(&dir);
+	if (sv_string_cmp(name, "ifdef") ||
+		sv_string_cmp(name, "elifdef")) {
+		return (define_map_get(next_spelling()) != NULL);
+	} else if (sv_string_cmp(name, "ifndef") ||
+			   sv_string_cmp(name, "elifndef")) {
+		return !(define_map_get(next_spelling()) != NULL);
+	} else if (sv_string_cmp(name, "if") ||
+			   sv_string_cmp(name, "elif")) {
 		return !result_is_zero(evaluate_until_newline());
-	} else if (sv_string_cmp(dir.str, "else")) {
+	} else if (sv_string_cmp(name, "else")) {
 		return 1;
 	}
 
-	ERROR(dir.pos, "Invalid conditional directive");
+	ERROR(token_position(&dir), "Invalid conditional directive");
 }
 
-static void push_macro(struct string_view name) {
+static void push_macro(uint32_t name) {
 	struct macro_stack *stack = NULL;
 	for (unsigned i = 0; i < macro_stack_size; i++) {
 		if (macro_stacks[i].size &&
-			sv_cmp(macro_stacks[i].defines[0].name, name)) {
+			macro_stacks[i].defines[0].name == name) {
 			stack = &macro_stacks[i];
 		}
 	}
@@ -422,11 +519,11 @@ static void push_macro(struct string_view name) {
 		ADD_ELEMENT(stack->size, stack->cap, stack->defines) = *current_define;
 }
 
-static void pop_macro(struct string_view name) {
+static void pop_macro(uint32_t name) {
 	struct macro_stack *stack = NULL;
 	for (unsigned i = 0; i < macro_stack_size; i++) {
 		if (macro_stacks[i].size &&
-			sv_cmp(macro_stacks[i].defines[0].name, name)) {
+			macro_stacks[i].defines[0].name == name) {
 			stack = &macro_stacks[i];
 		}
 	}
@@ -442,41 +539,42 @@ static void pop_macro(struct string_view name) {
 
 static int directiver_handle_pragma(void) {
 	struct token command = next();
+	struct string_view command_str = token_str(&command);
 
-	if (sv_string_cmp(command.str, "once")) {
-		input_disable_path(current_file->path);
-	} else if (sv_string_cmp(command.str, "push_macro")) {
+	if (sv_string_cmp(command_str, "once")) {
+		input_disable_file(current_file->file);
+	} else if (sv_string_cmp(command_str, "push_macro")) {
 		struct token lpar = next();
 		if (lpar.type != T_LPAR)
-			ERROR(lpar.pos, "Expected (, got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&lpar), "Expected (, got %s", dbg_token_type(lpar.type));
 		struct token name_token = next();
 		if (name_token.type != T_STRING)
-			ERROR(name_token.pos, "Expected string got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&name_token), "Expected string got %s", dbg_token_type(lpar.type));
 		struct token rpar = next();
 		if (rpar.type != T_RPAR)
-			ERROR(rpar.pos, "Expected ), got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&rpar), "Expected ), got %s", dbg_token_type(lpar.type));
 
-		struct string_view name = name_token.str;
+		struct string_view name = token_str(&name_token);
 		name.str++;
 		name.len -= 2;
 
-		push_macro(name);
-	} else if (sv_string_cmp(command.str, "pop_macro")) {
+		push_macro(intern(name));
+	} else if (sv_string_cmp(command_str, "pop_macro")) {
 		struct token lpar = next();
 		if (lpar.type != T_LPAR)
-			ERROR(lpar.pos, "Expected (, got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&lpar), "Expected (, got %s", dbg_token_type(lpar.type));
 		struct token name_token = next();
 		if (name_token.type != T_STRING)
-			ERROR(name_token.pos, "Expected string got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&name_token), "Expected string got %s", dbg_token_type(lpar.type));
 		struct token rpar = next();
 		if (rpar.type != T_RPAR)
-			ERROR(rpar.pos, "Expected ), got %s", dbg_token_type(lpar.type));
+			ERROR(token_position(&rpar), "Expected ), got %s", dbg_token_type(lpar.type));
 
-		struct string_view name = name_token.str;
+		struct string_view name = token_str(&name_token);
 		name.str++;
 		name.len -= 2;
 
-		pop_macro(name);
+		pop_macro(intern(name));
 	} else {
 		push(command);
 		return 1;
@@ -513,7 +611,7 @@ struct token directiver_next(void) {
 			continue;
 		}
 
-		struct string_view name = directive.str;
+		struct string_view name = token_str(&directive);
 
 		assert(directive.type == T_IDENT);
 
@@ -542,13 +640,14 @@ struct token directiver_next(void) {
 			if (sv_string_cmp(name, "define")) {
 				directiver_define();
 			} else if (sv_string_cmp(name, "undef")) {
-				define_map_remove(next().str);
+				define_map_remove(next_spelling());
 			} else if (sv_string_cmp(name, "error")) {
 				struct token msg = next();
+				struct string_view msg_str = token_str(&msg);
 				if (msg.type == T_STRING)
-					ERROR(directive.pos, "#error directive was invoked with message: \"%.*s\".", msg.str.len, msg.str.str);
+					ERROR(token_position(&directive), "#error directive was invoked with message: \"%.*s\".", msg_str.len, msg_str.str);
 				else
-					ERROR(directive.pos, "#error directive was invoked.");
+					ERROR(token_position(&directive), "#error directive was invoked.");
 			} else if (sv_string_cmp(name, "include")) {
 				// There is an issue with just resetting after include. But
 				// I'm interpreting the standard liberally to allow for this.
@@ -556,18 +655,18 @@ struct token directiver_next(void) {
 				line_diff = 0;
 				struct string_view path;
 				struct token path_tok = next();
-				int system;
+				int angled;
 				if (path_tok.type == PP_HEADER_NAME_H ||
 					path_tok.type == PP_HEADER_NAME_Q) {
-					path = path_tok.str;
-					system = path_tok.type == PP_HEADER_NAME_H;
+					path = token_str(&path_tok);
+					angled = path_tok.type == PP_HEADER_NAME_H;
 					path.len -= 2;
 					path.str++;
 				} else {
-					path = get_include_path(directive, path_tok, &system);
+					path = get_include_path(directive, path_tok, &angled);
 				}
 
-				directiver_push_input(sv_to_str(path), system);
+				directiver_push_input(arena_strndup(&preprocessor_arena, path.str, path.len), angled);
 			} else if (sv_string_cmp(name, "endif")) {
 				// Do nothing.
 			} else if (sv_string_cmp(name, "pragma")) {
@@ -582,7 +681,7 @@ struct token directiver_next(void) {
 				struct token digit_seq = next(), s_char_seq;
 
 				if (digit_seq.first_of_line)
-					ERROR(digit_seq.pos, "Expected digit sequence after #line");
+					ERROR(token_position(&digit_seq), "Expected digit sequence after #line");
 
 				int has_s_char_seq = 0;
 				if (digit_seq.type != T_NUM) {
@@ -598,7 +697,7 @@ struct token directiver_next(void) {
 					expand_token_list(&buffer);
 
 					if (buffer.size == 0) {
-						ERROR(digit_seq.pos, "Invalid #line macro expansion");
+						ERROR(token_position(&digit_seq), "Invalid #line macro expansion");
 					} else if (buffer.size >= 1) {
 						digit_seq = buffer.list[0];
 					} else if (buffer.size >= 2) {
@@ -615,19 +714,31 @@ struct token directiver_next(void) {
 				}
 
 				if (digit_seq.first_of_line || digit_seq.type != T_NUM)
-					ERROR(digit_seq.pos, "Expected digit sequence after #line");
+					ERROR(token_position(&digit_seq), "Expected digit sequence after #line");
 
-				line_diff += atoi(sv_to_str(digit_seq.str)) - directive.pos.line - 1;
+				struct string_view digits = token_str(&digit_seq);
+				line_diff += atoi(arena_strndup(&preprocessor_arena, digits.str, digits.len)) - token_position(&directive).line - 1;
 
 				if (has_s_char_seq) {
 					if (s_char_seq.type != T_STRING)
-						ERROR(s_char_seq.pos, "Expected s char sequence as second argument to #line");
-					s_char_seq.str.len -= 2;
-					s_char_seq.str.str++;
-					new_path = sv_to_str(s_char_seq.str);
+						ERROR(token_position(&s_char_seq), "Expected s char sequence as second argument to #line");
+					// Escape sequences in the path are decoded, as written by -E.
+					struct string_view path = token_str(&s_char_seq);
+					char *path_str = arena_alloc(&preprocessor_arena, path.len);
+					const char *end = path.str + path.len - 1;
+					int len = 0;
+					for (const char *c = path.str + 1; c < end;) {
+						uint32_t escaped;
+						if (escape_sequence_read(&escaped, &c, end - c))
+							path_str[len++] = escaped;
+						else
+							path_str[len++] = *c++;
+					}
+					path_str[len] = '\0';
+					new_path = path_str;
 				}
 			} else {
-				ERROR(directive.pos, "#%s not implemented", dbg_token(&directive));
+				ERROR(token_position(&directive), "#%s not implemented", dbg_token(&directive));
 			}
 		}
 
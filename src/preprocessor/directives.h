@@ -4,10 +4,18 @@
 #include "preprocessor.h"
 
 struct token directiver_next(void);
-void directiver_push_input(const char *path, int system);
+void directiver_push_input(const char *path, int angled);
 void directiver_reset(void);
 
 void directiver_write_dependencies(void);
+// Files found in system include paths, or included from them, are not
+// recorded. Used for -MM.
+void directiver_skip_system_dependencies(void);
+void directiver_print_dependencies(FILE *fp, const char *mt);
+// Writes to stdout if mf is NULL.
 void directiver_finish_writing_dependencies(const char *mt, const char *mf);
+// Files included so far, only recorded when dependencies are written.
+char **directiver_get_dependencies(size_t *n);
+void directiver_add_dependency(const char *path);
 
 #endif
@@ -0,0 +1,259 @@
+#include "hide_set.h"
+
+#include <common.h>
+#include <mem_report.h>
+
+#include <string.h>
+
+// Members of all sets, each set is a sorted range of this array.
+static size_t members_size, members_cap;
+static uint32_t *members;
+
+static size_t sets_size, sets_cap;
+static struct set {
+	uint32_t start, size, hash;
+} *sets;
+
+// Open addressing table of set handles, 0 marks an empty slot.
+static size_t set_table_cap;
+static uint32_t *set_table;
+
+// Results of earlier operations, op 0 marks an empty slot.
+enum {
+	OP_INSERT = 1,
+	OP_UNION,
+	OP_INTERSECTION
+};
+
+static size_t memo_size, memo_cap;
+static struct memo {
+	uint32_t op, a, b, result;
+} *memo;
+
+// Scratch buffer for building new sets.
+static size_t scratch_size, scratch_cap;
+static uint32_t *scratch;
+
+static uint32_t hash_members(const uint32_t *list, size_t size) {
+	uint32_t hash = 0;
+	for (size_t i = 0; i < size; i++)
+		hash = hash32(hash ^ list[i]);
+	return hash;
+}
+
+static uint32_t *set_table_find(const uint32_t *list, uint32_t size, uint32_t hash) {
+	size_t idx = hash & (set_table_cap - 1);
+	while (set_table[idx]) {
+		struct set *set = &sets[set_table[idx]];
+		if (set->hash == hash && set->size == size &&
+			memcmp(members + set->start, list, sizeof *list * size) == 0)
+			break;
+		idx = (idx + 1) & (set_table_cap - 1);
+	}
+	return &set_table[idx];
+}
+
+static void set_table_grow(void) {
+	free(set_table);
+	set_table_cap = MAX(set_table_cap * 2, 1024);
+	set_table = cc_malloc(sizeof *set_table * set_table_cap);
+	memset(set_table, 0, sizeof *set_table * set_table_cap);
+
+	for (uint32_t i = 1; i < sets_size; i++)
+		*set_table_find(members + sets[i].start, sets[i].size, sets[i].hash) = i;
+}
+
+// Returns the handle of the set in scratch.
+static uint32_t intern_scratch(void) {
+	if (!scratch_size)
+		return 0;
+
+	if (sets_size * 2 >= set_table_cap) {
+		if (!sets_size)
+			ADD_ELEMENT(sets_size, sets_cap, sets) = (struct set) { 0 };
+		set_table_grow();
+	}
+
+	uint32_t hash = hash_members(scratch, scratch_size);
+	uint32_t *slot = set_table_find(scratch, scratch_size, hash);
+
+	if (*slot)
+		return *slot;
+
+	uint32_t start = members_size;
+	for (size_t i = 0; i < scratch_size; i++)
+		ADD_ELEMENT(members_size, members_cap, members) = scratch[i];
+
+	*slot = sets_size;
+	ADD_ELEMENT(sets_size, sets_cap, sets) = (struct set) { start, scratch_size, hash };
+	return *slot;
+}
+
+static uint32_t memo_hash(uint32_t op, uint32_t a, uint32_t b) {
+	return hash32(hash32(op ^ a) ^ b);
+}
+
+static struct memo *memo_find(uint32_t op, uint32_t a, uint32_t b) {
+	size_t idx = memo_hash(op, a, b) & (memo_cap - 1);
+	while (memo[idx].op && !(memo[idx].op == op && memo[idx].a == a && memo[idx].b == b))
+		idx = (idx + 1) & (memo_cap - 1);
+	return &memo[idx];
+}
+
+static void memo_grow(void) {
+	struct memo *old = memo;
+	size_t old_cap = memo_cap;
+
+	memo_cap = MAX(memo_cap * 2, 1024);
+	memo = cc_malloc(sizeof *memo * memo_cap);
+	memset(memo, 0, sizeof *memo * memo_cap);
+
+	for (size_t i = 0; i < old_cap; i++) {
+		if (old[i].op)
+			*memo_find(old[i].op, old[i].a, old[i].b) = old[i];
+	}
+
+	free(old);
+}
+
+static struct memo *memo_get(uint32_t op, uint32_t a, uint32_t b) {
+	if (memo_size * 2 >= memo_cap)
+		memo_grow();
+	return memo_find(op, a, b);
+}
+
+static uint32_t memo_set(struct memo *entry, uint32_t op, uint32_t a, uint32_t b, uint32_t result) {
+	*entry = (struct memo) { op, a, b, result };
+	memo_size++;
+	return result;
+}
+
+// Merges the sorted sets a and b into scratch.
+static void merge(uint32_t a, uint32_t b, int intersection) {
+	const uint32_t *la = members + sets[a].start, *lb = members + sets[b].start;
+	uint32_t na = sets[a].size, nb = sets[b].size, ia = 0, ib = 0;
+
+	scratch_size = 0;
+	while (ia < na && ib < nb) {
+		if (la[ia] == lb[ib]) {
+			ADD_ELEMENT(scratch_size, scratch_cap, scratch) = la[ia];
+			ia++, ib++;
+		} else if (la[ia] < lb[ib]) {
+			if (!intersection)
+				ADD_ELEMENT(scratch_size, scratch_cap, scratch) = la[ia];
+			ia++;
+		} else {
+			if (!intersection)
+				ADD_ELEMENT(scratch_size, scratch_cap, scratch) = lb[ib];
+			ib++;
+		}
+	}
+
+	if (!intersection) {
+		for (; ia < na; ia++)
+			ADD_ELEMENT(scratch_size, scratch_cap, scratch) = la[ia];
+		for (; ib < nb; ib++)
+			ADD_ELEMENT(scratch_size, scratch_cap, scratch) = lb[ib];
+	}
+}
+
+uint32_t hide_set_insert(uint32_t hs, uint32_t name) {
+	if (hide_set_contains(hs, name))
+		return hs;
+
+	enum mem_tag prev_tag = mem_tag_set(MEM_HIDE_SET);
+
+	struct memo *entry = memo_get(OP_INSERT, hs, name);
+	if (entry->op) {
+		mem_tag_set(prev_tag);
+		return entry->result;
+	}
+
+	const uint32_t *list = hs ? members + sets[hs].start : NULL;
+	uint32_t size = hs ? sets[hs].size : 0, i = 0;
+
+	scratch_size = 0;
+	for (; i < size && list[i] < name; i++)
+		ADD_ELEMENT(scratch_size, scratch_cap, scratch) = list[i];
+	ADD_ELEMENT(scratch_size, scratch_cap, scratch) = name;
+	for (; i < size; i++)
+		ADD_ELEMENT(scratch_size, scratch_cap, scratch) = list[i];
+
+	uint32_t result = intern_scratch();
+	mem_tag_set(prev_tag);
+
+	// intern_scratch does not touch the memo table, entry is still valid.
+	return memo_set(entry, OP_INSERT, hs, name, result);
+}
+
+static uint32_t combine(uint32_t op, uint32_t a, uint32_t b) {
+	// Both operations are commutative.
+	if (a > b) {
+		uint32_t tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	enum mem_tag prev_tag = mem_tag_set(MEM_HIDE_SET);
+
+	struct memo *entry = memo_get(op, a, b);
+	if (entry->op) {
+		mem_tag_set(prev_tag);
+		return entry->result;
+	}
+
+	merge(a, b, op == OP_INTERSECTION);
+	uint32_t result = intern_scratch();
+	mem_tag_set(prev_tag);
+
+	return memo_set(entry, op, a, b, result);
+}
+
+uint32_t hide_set_union(uint32_t a, uint32_t b) {
+	if (!a || a == b)
+		return b;
+	if (!b)
+		return a;
+
+	return combine(OP_UNION, a, b);
+}
+
+uint32_t hide_set_intersection(uint32_t a, uint32_t b) {
+	if (!a || !b)
+		return 0;
+	if (a == b)
+		return a;
+
+	return combine(OP_INTERSECTION, a, b);
+}
+
+int hide_set_contains(uint32_t hs, uint32_t name) {
+	if (!hs)
+		return 0;
+
+	const uint32_t *list = members + sets[hs].start;
+	uint32_t lo = 0, hi = sets[hs].size;
+	while (lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		if (list[mid] == name)
+			return 1;
+		else if (list[mid] < name)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return 0;
+}
+
+void hide_set_reset(void) {
+	free(members);
+	free(sets);
+	free(set_table);
+	free(memo);
+	free(scratch);
+	members = scratch = set_table = NULL;
+	sets = NULL;
+	memo = NULL;
+	members_size = members_cap = sets_size = sets_cap = set_table_cap = 0;
+	memo_size = memo_cap = scratch_size = scratch_cap = 0;
+}
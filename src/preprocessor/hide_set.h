@@ -0,0 +1,17 @@
+#ifndef HIDE_SET_H
+#define HIDE_SET_H
+
+#include <stdint.h>
+
+// Hide sets of macro expansion, as immutable sets of interned macro names
+// referred to by 32-bit handles. Handle 0 is the empty set.
+// Sets are hash-consed, two sets are equal only if their handles are equal.
+
+uint32_t hide_set_insert(uint32_t hs, uint32_t name);
+uint32_t hide_set_union(uint32_t a, uint32_t b);
+uint32_t hide_set_intersection(uint32_t a, uint32_t b);
+int hide_set_contains(uint32_t hs, uint32_t name);
+
+void hide_set_reset(void);
+
+#endif
@@ -1,4 +1,13 @@
+#define _DEFAULT_SOURCE // For MAP_ANONYMOUS.
+
 #include "input.h"
+#include "macro_expander.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <common.h>
 
@@ -6,19 +15,110 @@
 #include <errno.h>
 
 static size_t paths_size = 0, paths_cap;
-static const char **paths = NULL;
+static struct include_path {
+	const char *path;
+	int system;
+} *paths = NULL;
+
+// Every file that has been included, identified by device and inode so that
+// different paths to the same file are treated as the same file.
+static size_t files_size, files_cap;
+static struct input_file {
+	dev_t dev;
+	ino_t ino;
+	int once; // #pragma once.
+	uint32_t guard; // Interned name of the include guard macro, or 0.
+} *files;
+
+// Open addressing table of indices into files plus one, 0 is an empty slot.
+static size_t file_table_cap;
+static uint32_t *file_table;
+
+static uint32_t hash_file(dev_t dev, ino_t ino) {
+	return hash32((uint32_t)dev ^ hash32((uint32_t)ino ^ (uint32_t)((uint64_t)ino >> 32)));
+}
 
-// Used for #pragma once.
-static struct string_set disabled_headers;
+static uint32_t *file_table_find(dev_t dev, ino_t ino) {
+	size_t idx = hash_file(dev, ino) & (file_table_cap - 1);
+	while (file_table[idx] &&
+		   !(files[file_table[idx] - 1].dev == dev && files[file_table[idx] - 1].ino == ino))
+		idx = (idx + 1) & (file_table_cap - 1);
+	return &file_table[idx];
+}
+
+static int get_file(dev_t dev, ino_t ino) {
+	if (files_size * 2 >= file_table_cap) {
+		free(file_table);
+		file_table_cap = MAX(file_table_cap * 2, 64);
+		file_table = cc_malloc(sizeof *file_table * file_table_cap);
+		memset(file_table, 0, sizeof *file_table * file_table_cap);
+		for (size_t i = 0; i < files_size; i++)
+			*file_table_find(files[i].dev, files[i].ino) = i + 1;
+	}
 
-static struct input input_create(const char *path, FILE *fp) {
-	fseek(fp, 0, SEEK_END);
-	size_t size = ftell(fp);
-	rewind(fp);
+	uint32_t *slot = file_table_find(dev, ino);
+	if (!*slot) {
+		ADD_ELEMENT(files_size, files_cap, files) = (struct input_file) { .dev = dev, .ino = ino };
+		*slot = files_size;
+	}
+
+	return *slot - 1;
+}
+
+// Files are mapped read-only and stay mapped until input_reset, since
+// tokens and interned strings point into them.
+static size_t mappings_size, mappings_cap;
+static struct mapping {
+	void *addr;
+	size_t size;
+} *mappings;
+
+// Maps the file followed by at least one zero byte, or returns NULL.
+// Bytes after the end of the file in its last page are zero, and the
+// mapping is placed in a larger anonymous mapping whose remaining pages are
+// zero, so the contents are always terminated.
+static char *map_file(int fd, size_t size, int keep) {
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t map_size = (size / page_size + 1) * page_size;
+
+	char *addr = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (addr == MAP_FAILED)
+		return NULL;
+
+	if (size && mmap(addr, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(addr, map_size);
+		return NULL;
+	}
+
+	if (!keep)
+		ADD_ELEMENT(mappings_size, mappings_cap, mappings) = (struct mapping) { addr, map_size };
+	return addr;
+}
+
+// Contents are kept for the whole process if keep is set.
+static struct input input_create(const char *path, int keep) {
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+		ICE("Error opening file %s, %s", path, strerror(errno));
+
+	size_t size = st.st_size;
+	char *contents = map_file(fd, size, keep);
+
+	if (!contents) {
+		// Not mappable, read it instead.
+		contents = keep ? cc_malloc(size + 1) : arena_alloc(&preprocessor_arena, size + 1);
+		size_t pos = 0;
+		while (pos < size) {
+			ssize_t n = read(fd, contents + pos, size - pos);
+			if (n <= 0)
+				ICE("Error reading file %s", path);
+			pos += n;
+		}
+		contents[size] = '\0';
+	}
 
-	char *contents = cc_malloc(size + 1);
-	fread(contents, size, 1, fp);
-	contents[size] = '\0';
+	close(fd);
 
 	return (struct input) { .path = path, .contents = contents };
 }
@@ -32,59 +132,341 @@ static int length_of_path_without_filename(const char *str) {
 	return slash_pos;
 }
 
-static FILE *try_open_file(const char *path) {
-	FILE *fp = fopen(path, "r");
-	if (!fp && errno != ENOENT) {
+// Lookups done while searching for included files. These are kept for the
+// whole process, the file system and the include paths are assumed to not
+// change during compilation.
+// Keys are strings, values are indices into stat_results, or -1 if missing.
+struct lookup_map {
+	size_t size, cap;
+	struct lookup_entry {
+		char *key;
+		uint32_t hash;
+		int value;
+		int system; // Found in a system include path, only set in resolve_map.
+	} *entries;
+};
+
+static struct lookup_map stat_map, resolve_map;
+
+static size_t stat_results_size, stat_results_cap;
+static struct stat_result {
+	char *path;
+	dev_t dev;
+	ino_t ino;
+	const char *contents; // Only set if contents are cached.
+} *stat_results;
+
+static int cache_contents;
+
+void input_cache_contents(void) {
+	cache_contents = 1;
+}
+
+static struct lookup_entry *lookup_find(struct lookup_map *map, const char *key, uint32_t hash) {
+	size_t idx = hash & (map->cap - 1);
+	while (map->entries[idx].key &&
+		   !(map->entries[idx].hash == hash && strcmp(map->entries[idx].key, key) == 0))
+		idx = (idx + 1) & (map->cap - 1);
+	return &map->entries[idx];
+}
+
+// Returns the entry of key, with an empty key if it is not in the map.
+static struct lookup_entry *lookup_get(struct lookup_map *map, const char *key) {
+	if (map->size * 2 >= map->cap) {
+		struct lookup_entry *old = map->entries;
+		size_t old_cap = map->cap;
+
+		map->cap = MAX(map->cap * 2, 256);
+		map->entries = cc_malloc(sizeof *map->entries * map->cap);
+		memset(map->entries, 0, sizeof *map->entries * map->cap);
+
+		for (size_t i = 0; i < old_cap; i++) {
+			if (old[i].key)
+				*lookup_find(map, old[i].key, old[i].hash) = old[i];
+		}
+
+		free(old);
+	}
+
+	return lookup_find(map, key, sv_hash(sv_from_str((char *)key)));
+}
+
+static void lookup_set(struct lookup_map *map, struct lookup_entry *entry, const char *key, int value) {
+	*entry = (struct lookup_entry) {
+		.key = strdup(key),
+		.hash = sv_hash(sv_from_str((char *)key)),
+		.value = value
+	};
+	map->size++;
+}
+
+// Returns the index in stat_results, or -1 if the file does not exist.
+static int try_stat_file(const char *path) {
+	struct lookup_entry *entry = lookup_get(&stat_map, path);
+	if (entry->key)
+		return entry->value;
+
+	struct stat st;
+	int result = -1;
+	if (stat(path, &st) == 0) {
+		result = stat_results_size;
+		ADD_ELEMENT(stat_results_size, stat_results_cap, stat_results) = (struct stat_result) {
+			.path = strdup(path),
+			.dev = st.st_dev,
+			.ino = st.st_ino
+		};
+	} else if (errno != ENOENT) {
 		char *str = strerror(errno);
 		ICE("Error opening file %s, %s", path, str);
 	}
-	return fp;
+
+	lookup_set(&stat_map, entry, path, result);
+	return result;
+}
+
+// Ranges of locations, in increasing order of base.
+struct location_file {
+	uint32_t base, size;
+	const char *path, *contents;
+	int line_diff;
+	// Remapped files share contents with the original file.
+	struct location_file *original;
+
+	// Offsets of the newlines in contents, created when first needed.
+	int n_newlines;
+	uint32_t *newlines;
+};
+
+static size_t location_files_size, location_files_cap;
+static struct location_file *location_files;
+static uint32_t next_location = 1;
+
+// #line applies to all following tokens, so the last remapping is
+// usually reused.
+static uint32_t last_original, last_base;
+static const char *last_path;
+static int last_line_diff;
+
+static uint32_t add_location_range(struct location_file file) {
+	uint32_t size = strlen(file.contents) + 1;
+	if (next_location + size < next_location || next_location + size > UINT32_MAX / 2)
+		ICE("Too much input in a single translation unit.");
+
+	file.base = next_location;
+	file.size = size;
+	next_location += size;
+
+	ADD_ELEMENT(location_files_size, location_files_cap, location_files) = file;
+	return file.base;
+}
+
+uint32_t location_add_file(const char *path, const char *contents) {
+	return add_location_range((struct location_file) { .path = path, .contents = contents });
+}
+
+static struct location_file *find_location_file(uint32_t loc) {
+	size_t lo = 0, hi = location_files_size;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (location_files[mid].base <= loc)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return &location_files[lo];
+}
+
+uint32_t location_remap(uint32_t loc, const char *path, int line_diff) {
+	if (!loc)
+		return 0;
+
+	struct location_file *file = find_location_file(loc);
+	uint32_t offset = loc - file->base;
+	if (file->original)
+		file = file->original;
+
+	if (last_base && last_original == file->base &&
+		last_path == path && last_line_diff == line_diff)
+		return last_base + offset;
+
+	size_t original_idx = file - location_files;
+	uint32_t base = add_location_range((struct location_file) {
+			.path = path ? path : file->path,
+			.contents = file->contents,
+			.line_diff = line_diff,
+		});
+
+	// location_files might have been reallocated.
+	location_files[location_files_size - 1].original = location_files + original_idx;
+
+	last_original = location_files[original_idx].base;
+	last_base = base;
+	last_path = path;
+	last_line_diff = line_diff;
+
+	return base + offset;
+}
+
+struct position location_resolve(uint32_t loc) {
+	if (!loc)
+		return (struct position) { 0 };
+
+	struct location_file *file = find_location_file(loc);
+	struct location_file *lines = file->original ? file->original : file;
+	uint32_t offset = loc - file->base;
+
+	if (!lines->newlines) {
+		int cap = 0;
+		for (uint32_t i = 0; lines->contents[i]; i++) {
+			if (lines->contents[i] == '\n')
+				ADD_ELEMENT(lines->n_newlines, cap, lines->newlines) = i;
+		}
+		// Sentinel, also marks the table as created.
+		ADD_ELEMENT(lines->n_newlines, cap, lines->newlines) = UINT32_MAX;
+		lines->n_newlines--;
+	}
+
+	// Number of newlines before offset.
+	int lo = 0, hi = lines->n_newlines;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (lines->newlines[mid] < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	// Columns count from the preceding newline, which is column 1.
+	int line_start = lo ? (int)lines->newlines[lo - 1] : -1;
+
+	return (struct position) {
+		.path = file->path,
+		.line = lo + 1 + file->line_diff,
+		.column = offset - line_start + 1,
+	};
+}
+
+void location_reset(void) {
+	for (size_t i = 0; i < location_files_size; i++)
+		free(location_files[i].newlines);
+	free(location_files);
+	location_files = NULL;
+	location_files_size = location_files_cap = 0;
+	next_location = 1;
+	last_base = 0;
 }
 
 void input_reset(void) {
 	paths_size = paths_cap = 0;
 	free(paths);
 	paths = NULL;
-	disabled_headers = (struct string_set) { 0 };
+	free(files);
+	free(file_table);
+	files = NULL;
+	file_table = NULL;
+	files_size = files_cap = file_table_cap = 0;
+
+	for (size_t i = 0; i < mappings_size; i++)
+		munmap(mappings[i].addr, mappings[i].size);
+	free(mappings);
+	mappings = NULL;
+	mappings_size = mappings_cap = 0;
+}
+
+void input_add_include_path(const char *path, int system) {
+	ADD_ELEMENT(paths_size, paths_cap, paths) = (struct include_path) { path, system };
 }
 
-void input_add_include_path(const char *path) {
-	ADD_ELEMENT(paths_size, paths_cap, paths) = path;
+void input_disable_file(int file) {
+	files[file].once = 1;
 }
 
-void input_disable_path(const char *path) {
-	string_set_insert(&disabled_headers, strdup(path));
+void input_set_guard(int file, uint32_t guard) {
+	files[file].guard = guard;
 }
 
-struct input input_open(const char *parent_path, const char *path, int system) {
-	FILE *fp = NULL;
+int input_get_file_state(int i, struct input_file_state *state) {
+	if (i < 0 || (size_t)i >= files_size)
+		return 0;
 
-	static char *path_buffer = NULL;
-	static size_t path_capacity = 0;
+	*state = (struct input_file_state) {
+		.dev = files[i].dev,
+		.ino = files[i].ino,
+		.once = files[i].once,
+		.guard = files[i].guard
+	};
+	return 1;
+}
+
+void input_restore_file_state(struct input_file_state state) {
+	int file = get_file(state.dev, state.ino);
+	files[file].once = state.once;
+	files[file].guard = state.guard;
+}
 
-	if (!system) {
-		int length = length_of_path_without_filename(parent_path);
+// Sets *system if the file was found in a system include path.
+static int resolve_path(const char *parent_path, const char *path, int angled, int *system) {
+	static char *path_buffer = NULL, *key_buffer = NULL;
+	static size_t path_capacity = 0, key_capacity = 0;
+
+	// Only quoted includes depend on the directory of the includer.
+	int length = angled ? 0 : length_of_path_without_filename(parent_path);
+	expand_printf(&key_buffer, &key_capacity, "%c%.*s\n%s", angled ? '<' : '"',
+				  length, parent_path, path);
+
+	struct lookup_entry *entry = lookup_get(&resolve_map, key_buffer);
+	if (entry->key) {
+		*system = entry->system;
+		return entry->value;
+	}
 
+	int result = -1;
+	*system = 0;
+
+	if (!angled) {
 		expand_printf(&path_buffer, &path_capacity, "%.*s%s", length,
 		              parent_path, path);
-		fp = try_open_file(path_buffer);
+		result = try_stat_file(path_buffer);
 	}
 
-	for (unsigned i = 0; !fp && i < paths_size; i++) {
-		expand_printf(&path_buffer, &path_capacity, "%s/%s", paths[i], path);
-		fp = try_open_file(path_buffer);
+	for (unsigned i = 0; result < 0 && i < paths_size; i++) {
+		expand_printf(&path_buffer, &path_capacity, "%s/%s", paths[i].path, path);
+		result = try_stat_file(path_buffer);
+		*system = result >= 0 && paths[i].system;
 	}
 
-	if (!fp)
+	lookup_set(&resolve_map, entry, key_buffer, result);
+	entry->system = *system;
+	return result;
+}
+
+struct input input_open(const char *parent_path, const char *path, int angled) {
+	int system;
+	int found = resolve_path(parent_path, path, angled, &system);
+
+	if (found < 0)
 		ICE("\"%s\" not found in search path, with origin %s", path,
 		    parent_path);
 
-	struct input input = { 0 };
+	struct stat_result *st = &stat_results[found];
+	int file = get_file(st->dev, st->ino);
 
-	if (!string_set_contains(disabled_headers, sv_from_str(path_buffer)))
-		input = input_create(strdup(path_buffer), fp);
+	// The file would not produce any tokens, don't read it again.
+	if (files[file].once ||
+		(files[file].guard && define_map_get(files[file].guard)))
+		return (struct input) { 0 };
 
-	fclose(fp);
+	struct input input;
+	if (st->contents) {
+		input = (struct input) { .path = st->path, .contents = st->contents };
+	} else {
+		input = input_create(st->path, cache_contents);
+		if (cache_contents)
+			st->contents = input.contents;
+	}
+	input.file = file;
+	input.system = system;
 
 	return input;
 }
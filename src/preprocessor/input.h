@@ -1,19 +1,56 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include <stdint.h>
+
 struct position {
 	const char *path;
 	int line, column;
 };
 
+// Tokens store their position as a 32-bit location, which is an offset into
+// the location range of a file registered with location_add_file. Location 0
+// is no position. Positions are only computed when needed, by location_resolve.
+
+// Returns the first location of the contents.
+uint32_t location_add_file(const char *path, const char *contents);
+// Location of the same character as loc, but as if the file was named path
+// and its lines moved by line_diff, as done by #line.
+uint32_t location_remap(uint32_t loc, const char *path, int line_diff);
+struct position location_resolve(uint32_t loc);
+void location_reset(void);
+
 struct input {
 	const char *path, *contents;
+	int file; // Identifies the file, even if reached through another path.
+	int system; // Found in a system include path.
 };
 
-void input_add_include_path(const char *path);
-void input_disable_path(const char *path);
+// Paths are searched in the order they are added. System paths are the
+// default include paths, whose headers are left out by -MM.
+void input_add_include_path(const char *path, int system);
+// Keeps the contents of files for the whole process, instead of releasing
+// them at input_reset. Used when the same headers are read for many files.
+void input_cache_contents(void);
+// The file is skipped when included again, used for #pragma once.
+void input_disable_file(int file);
+// The file is skipped when included again while guard is defined.
+void input_set_guard(int file, uint32_t guard);
+
+// angled is set for #include <...>, which does not search the directory of
+// the includer.
+struct input input_open(const char *parent_path, const char *path, int angled);
+
+// State of an included file, saved in precompiled headers.
+struct input_file_state {
+	uint64_t dev, ino;
+	int once;
+	uint32_t guard;
+};
 
-struct input input_open(const char *parent_path, const char *path, int system);
+// Returns 0 if there is no file i.
+int input_get_file_state(int i, struct input_file_state *state);
+void input_restore_file_state(struct input_file_state state);
 
 void input_reset(void);
 
@@ -2,96 +2,147 @@
 #include "token_list.h"
 #include "directives.h"
 #include "tokenizer.h"
+#include "hide_set.h"
+#include "macro_report.h"
 
 #include <common.h>
 #include <escape_sequence.h>
 
 #include <assert.h>
 
-#define MAP_SIZE 1024
-struct define_map {
-	struct define **entries;
+// Open addressing with linear probing, keyed on interned names, with at
+// most half of the slots used. Removal shifts the following entries of the
+// probe sequence back, so no tombstones are needed.
+struct define_entry {
+	uint32_t name, hash; // Name 0 is an empty slot.
+	struct define *def;
 };
 
-static struct define_map *define_map = NULL;
+static size_t define_map_size, define_map_cap;
+static struct define_entry *define_map;
+
+// Set when a macro at the start of a line expanded to nothing, so that the
+// line starts at the next token instead.
+static int empty_first_of_line;
 
 void macro_expander_reset(void) {
-	free(define_map->entries);
 	free(define_map);
 	define_map = NULL;
-}
+	define_map_size = define_map_cap = 0;
+	empty_first_of_line = 0;
 
-void expand_buffer(int input, int return_output, struct token *t);
+	arena_reset(&preprocessor_arena);
+	macro_report_reset();
+}
 
-static void define_map_init(void) {
-	define_map = cc_malloc(sizeof *define_map);
+void expand_buffer(int input, int return_output, int final, struct token *t);
 
-	define_map->entries = cc_malloc(sizeof *define_map->entries * MAP_SIZE);
-	for (size_t i = 0; i < MAP_SIZE; i++) {
-		define_map->entries[i] = NULL;
-	}
+static size_t define_map_find(uint32_t name, uint32_t hash) {
+	size_t mask = define_map_cap - 1, idx = hash & mask;
+	while (define_map[idx].name && define_map[idx].name != name)
+		idx = (idx + 1) & mask;
+	return idx;
 }
 
-static struct define **define_map_find(struct string_view name) {
-	if (!define_map)
-		define_map_init();
+static void define_map_grow(void) {
+	struct define_entry *old = define_map;
+	size_t old_cap = define_map_cap;
 
-	uint32_t hash_idx = sv_hash(name) % MAP_SIZE;
+	define_map_cap = MAX(define_map_cap * 2, 1024);
+	define_map = cc_malloc(sizeof *define_map * define_map_cap);
+	memset(define_map, 0, sizeof *define_map * define_map_cap);
 
-	struct define **it = &define_map->entries[hash_idx];
-
-	while (*it && !sv_cmp((*it)->name, name)) {
-		it = &(*it)->next;
+	for (size_t i = 0; i < old_cap; i++) {
+		if (old[i].name)
+			define_map[define_map_find(old[i].name, old[i].hash)] = old[i];
 	}
 
-	return it;
+	free(old);
 }
 
 void define_map_add(struct define define) {
-	struct define **elem = define_map_find(define.name);
+	if (2 * (define_map_size + 1) > define_map_cap)
+		define_map_grow();
 
 	if (define.def.size) { // Initial and ending whitespace of definition is ignored.
 		define.def.list[0].whitespace = 0;
 		define.def.list[define.def.size - 1].whitespace_after = 0;
 	}
 
-	if (*elem) {
-		define.next = (*elem)->next;
-		**elem = define;
+	uint32_t hash = intern_hash(define.name);
+	struct define_entry *entry = &define_map[define_map_find(define.name, hash)];
+
+	if (entry->name) {
+		*entry->def = define;
 	} else {
-		define.next = NULL;
-		*elem = cc_malloc(sizeof define);
-		**elem = define;
+		*entry = (struct define_entry) {
+			.name = define.name,
+			.hash = hash,
+			.def = ARENA_ALLOC(&preprocessor_arena, define),
+		};
+		define_map_size++;
 	}
 }
 
-struct define *define_map_get(struct string_view str) {
-	return *define_map_find(str);
+struct define *define_map_get(uint32_t name) {
+	if (!define_map)
+		return NULL;
+
+	return define_map[define_map_find(name, intern_hash(name))].def;
+}
+
+void define_map_remove(uint32_t name) {
+	if (!define_map)
+		return;
+
+	size_t mask = define_map_cap - 1;
+	size_t hole = define_map_find(name, intern_hash(name));
+	if (!define_map[hole].name)
+		return;
+
+	define_map_size--;
+
+	for (;;) {
+		define_map[hole] = (struct define_entry) { 0 };
+
+		// Find the next entry that may be moved into the hole, that is
+		// one whose home slot is not cyclically in (hole, idx].
+		size_t idx = hole;
+		for (;;) {
+			idx = (idx + 1) & mask;
+			if (!define_map[idx].name)
+				return;
+
+			size_t home = define_map[idx].hash & mask;
+			if (idx > hole ? (home <= hole || home > idx) : (home <= hole && home > idx))
+				break;
+		}
+
+		define_map[hole] = define_map[idx];
+		hole = idx;
+	}
 }
 
-void define_map_remove(struct string_view str) {
-	struct define **elem = define_map_find(str);
-	if (*elem) {
-		struct define *next = (*elem)->next;
-		free(*elem);
-		*elem = next;
-		// TODO: Free contents of elem as well.
+void define_map_for_each(define_map_function f, void *data) {
+	for (size_t i = 0; i < define_map_cap; i++) {
+		if (define_map[i].name)
+			f(define_map[i].def, data);
 	}
 }
 
-struct define define_init(struct string_view name) {
+struct define define_init(uint32_t name) {
 	return (struct define) {
 		.name = name,
 	};
 }
 
 void define_add_def(struct define *d, struct token t) {
-	token_list_add(&d->def, t);
+	ARENA_ADD_ELEMENT(&preprocessor_arena, d->def.size, d->def.cap, d->def.list) = t;
 }
 
 void define_add_par(struct define *d, struct token t) {
 	d->func = 1;
-	token_list_add(&d->par, t);
+	ARENA_ADD_ELEMENT(&preprocessor_arena, d->par.size, d->par.cap, d->par.list) = t;
 }
 
 static int get_param(struct define *def, struct token tok) {
@@ -102,8 +153,12 @@ static int get_param(struct define *def, struct token tok) {
 }
 
 void define_string(char *name, char *value) {
-	struct define def = define_init(sv_from_str(strdup(name)));
-	def.def = tokenize_input(value, "<string>");
+	struct define def = define_init(intern_copy(sv_from_str(name)));
+	struct tokenizer tokenizer;
+	tokenizer_init(&tokenizer, value, "<string>");
+	for (struct token t = tokenizer_next(&tokenizer); t.type != T_EOI;
+		 t = tokenizer_next(&tokenizer))
+		define_add_def(&def, t);
 	define_map_add(def);
 }
 
@@ -148,15 +203,20 @@ static struct token glue(struct token a, struct token b) {
 		.whitespace = b.whitespace, .first_of_line = b.first_of_line,
 		.whitespace_after = a.whitespace_after, .first_of_line_after = a.first_of_line_after
 	};
+	struct string_view a_str = token_str(&a), b_str = token_str(&b);
 	for (unsigned i = 0; i < sizeof paste_table / sizeof *paste_table; i++)
 		if (paste_table[i][1] == a.type && paste_table[i][0] == b.type)
 			ret.type = paste_table[i][2];
 	if (!ret.type)
-		ERROR(a.pos, "Invalid paste of %.*s and %.*s", b.str.len, b.str.str, a.str.len, a.str.str);
+		ERROR(token_position(&a), "Invalid paste of %.*s and %.*s", b_str.len, b_str.str, a_str.len, a_str.str);
 
-	ret.str = sv_from_str(allocate_printf("%s%s", sv_to_str(b.str), sv_to_str(a.str))); // TODO: This can be done better.
-	ret.hs = string_set_intersection(a.hs, b.hs);
-	ret.pos = a.pos;
+	char *str = arena_alloc(&preprocessor_arena, b_str.len + a_str.len + 1);
+	memcpy(str, b_str.str, b_str.len);
+	memcpy(str + b_str.len, a_str.str, a_str.len);
+	str[b_str.len + a_str.len] = '\0';
+	ret.spelling = intern(sv_from_str(str));
+	ret.hs = hide_set_intersection(a.hs, b.hs);
+	ret.loc = a.loc;
 
 	return ret;
 }
@@ -175,26 +235,24 @@ static void stringify_add_char(char c) {
 	ADD_ELEMENT(stringify_size, stringify_cap, stringify_buffer) = c;
 }
 
-static struct string_view stringify_end(void) {
+static uint32_t stringify_end(void) {
 	ADD_ELEMENT(stringify_size, stringify_cap, stringify_buffer) = '\"';
-	
-	struct string_view ret = { .len = stringify_size };
-	ret.str = cc_malloc(stringify_size);
-	memcpy(ret.str, stringify_buffer, stringify_size);
-	return ret;
+
+	return intern_copy((struct string_view) { .len = stringify_size, .str = stringify_buffer });
 }
 
 static void stringify_add(struct token *t, int start) {
 	if (!start && (t->whitespace || stringify_whitespace))
 		stringify_add_char(' ');
 	stringify_whitespace = t->whitespace_after;
+	struct string_view spelling = token_str(t);
 	const char *str = NULL;
 	switch (t->type) {
 	case T_STRING:
 	case T_CHARACTER_CONSTANT:
-		for (int i = 0; i < t->str.len; i++) {
+		for (int i = 0; i < spelling.len; i++) {
 			char escape_seq[5];
-			character_to_escape_sequence(t->str.str[i], escape_seq, 1);
+			character_to_escape_sequence(spelling.str[i], escape_seq, 1);
 			for (int j = 0; escape_seq[j]; j++)
 				stringify_add_char(escape_seq[j]);
 		}
@@ -218,8 +276,8 @@ static void stringify_add(struct token *t, int start) {
 		break;
 
 	default:
-		for (int i = 0; i < t->str.len; i++)
-			stringify_add_char(t->str.str[i]);
+		for (int i = 0; i < spelling.len; i++)
+			stringify_add_char(spelling.str[i]);
 	}
 
 	if (str) {
@@ -232,10 +290,14 @@ static int builtin_macros(struct token *t) {
 	// These are only single tokens.
 	// Remember to keep whitespace.
 	int whitespace = t->whitespace, whitespace_after = t->whitespace_after;
-	if (sv_string_cmp(t->str, "__LINE__")) {
-		*t = (struct token) { .type = T_NUM, .str = sv_from_str(allocate_printf("%d", t->pos.line)), .pos = t->pos };
-	} else if (sv_string_cmp(t->str, "__FILE__")) {
-		*t = (struct token) { .type = T_STRING, .str = sv_from_str(allocate_printf("\"%s\"", t->pos.path)), .pos = t->pos };
+	struct string_view name = token_str(t);
+	if (sv_string_cmp(name, "__LINE__")) {
+		char *str = arena_printf(&preprocessor_arena, "%d", token_position(t).line);
+		*t = (struct token) { .type = T_NUM, .spelling = intern(sv_from_str(str)), .loc = t->loc };
+	} else if (sv_string_cmp(name, "__FILE__")) {
+		struct position pos = token_position(t);
+		char *str = arena_printf(&preprocessor_arena, "\"%s\"", pos.path ? pos.path : "<built-in>");
+		*t = (struct token) { .type = T_STRING, .spelling = intern(sv_from_str(str)), .loc = t->loc };
 	} else
 		return 0;
 
@@ -255,9 +317,7 @@ static struct {
 } output_buffer;
 
 static void input_buffer_push(struct token *t) {
-	struct token n_token = *t;
-	n_token.hs = string_set_dup(n_token.hs);
-	ADD_ELEMENT(input_buffer.size, input_buffer.cap, input_buffer.tokens) = n_token;
+	ADD_ELEMENT(input_buffer.size, input_buffer.cap, input_buffer.tokens) = *t;
 }
 
 static struct token input_buffer_take(int input) {
@@ -344,7 +404,7 @@ static void expand_argument(struct token origin, struct token_list tl, int *conc
 
 	if (run_expand_again) {
 		size_t output_pos = output_buffer.size;
-		expand_buffer(input, 0, NULL);
+		expand_buffer(input, 0, 0, NULL);
 
 		for (int i = output_buffer.size - 1; i >= (int)output_pos; i--) {
 			input_buffer_push(&output_buffer.tokens[i]);
@@ -354,7 +414,7 @@ static void expand_argument(struct token origin, struct token_list tl, int *conc
 	}
 }
 
-static void subs_buffer(struct token origin, struct define *def, struct string_set *hs, struct position new_pos, int input) {
+static void subs_buffer(struct token origin, struct define *def, uint32_t *hs, uint32_t new_loc, int input) {
 	int n_args = def->par.size;
 	struct token_list *arguments = cc_malloc(sizeof *arguments * n_args);
 
@@ -372,7 +432,7 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 			if (input_buffer_parse_argument(&arguments[i], 0, input)) {
 				finished = 1;
 				if (i != n_args - 1)
-					ERROR(lpar.pos, "Wrong number of arguments to macro");
+					ERROR(token_position(&lpar), "Wrong number of arguments to macro");
 			}
 		}
 
@@ -380,7 +440,7 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 		if (def->vararg && !finished) {
 			vararg_included = 1;
 			if (!input_buffer_parse_argument(&vararg, 1, input)) {
-				ERROR(lpar.pos, "__VA_ARGS__ Not end of input");
+				ERROR(token_position(&lpar), "__VA_ARGS__ Not end of input");
 			}
 		}
 		
@@ -389,10 +449,10 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 
 		whitespace_after = rpar.whitespace_after;
 
-		*hs = string_set_intersection(*hs, rpar.hs);
+		*hs = hide_set_intersection(*hs, rpar.hs);
 	}
 
-	string_set_insert(hs, sv_to_str(def->name));
+	*hs = hide_set_insert(*hs, def->name);
 
 	size_t input_start = input_buffer.size;
 	int concat_with_prev = 0;
@@ -403,9 +463,9 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 		const int stringify = (i != 0) && def->def.list[i - 1].type == PP_HASH;
 
 		if (t.type == PP_HHASH)
-			ERROR(t.pos, "Concat token at edge of macro expansion.");
+			ERROR(token_position(&t), "Concat token at edge of macro expansion.");
 
-		if (sv_string_cmp(t.str, "__VA_ARGS__")) {
+		if (sv_string_cmp(token_str(&t), "__VA_ARGS__")) {
 			const int va_args_paste = concat && i - 2 >= 0 &&
 				def->def.list[i - 2].type == T_COMMA;
 
@@ -420,7 +480,8 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 
 				struct token t_new = t;
 				t_new.type = T_STRING;
-				t_new.str = stringify_end();
+				t_new.spelling = stringify_end();
+				t_new.loc = new_loc;
 				input_buffer_push(&t_new);
 			} else if (vararg_included) {
 				expand_argument(t, vararg, &concat_with_prev, concat, stringify, input);
@@ -439,7 +500,8 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 
 				struct token t_new = t;
 				t_new.type = T_STRING;
-				t_new.str = stringify_end();
+				t_new.spelling = stringify_end();
+				t_new.loc = new_loc;
 				input_buffer_push(&t_new);
 			} else if(idx >= 0) {
 				expand_argument(t, arguments[idx], &concat_with_prev, concat, stringify, input);
@@ -452,9 +514,9 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 					*end = glue(*end, t);
 					concat_with_prev = 0;
 				} else if (stringify) {
-					ERROR(t.pos, "# Should be followed by macro parameter");
+					ERROR(token_position(&t), "# Should be followed by macro parameter");
 				} else {
-					t.pos = new_pos;
+					t.loc = new_loc;
 					input_buffer_push(&t);
 				}
 
@@ -473,27 +535,49 @@ static void subs_buffer(struct token origin, struct define *def, struct string_s
 
 	for(unsigned i = input_start; i < input_buffer.size; i++) {
 		struct token *tok = &input_buffer.tokens[i];
-		tok->hs = string_set_union(*hs, tok->hs);
+		tok->hs = hide_set_union(*hs, tok->hs);
 
 		if (i == input_start)
 			tok->whitespace_after = tok->whitespace_after || whitespace_after;
-		if (i == input_buffer.size - 1)
+		if (i == input_buffer.size - 1) {
 			tok->whitespace = tok->whitespace || origin.whitespace;
+			tok->first_of_line = tok->first_of_line || origin.first_of_line;
+		}
+
+		// Pasted tokens have no position of their own.
+		if (!tok->loc)
+			tok->loc = new_loc;
 	}
 
+	if (input_start == input_buffer.size && origin.first_of_line)
+		empty_first_of_line = 1;
+
+	if (macro_report_enabled)
+		macro_report_substituted(input_start);
+
 	free(arguments);
 }
 
-// Expands until empty token.
-void expand_buffer(int input, int return_output, struct token *t) { 
+static void expand(int input, int return_output, int final, struct token *t) {
 	while (input || input_buffer.size) {
+		if (macro_report_enabled)
+			macro_report_take(input_buffer.size);
+
 		struct token top = input_buffer_take(input);
 		if (top.type == T_EOI)
 			break;
 
+		if (empty_first_of_line) {
+			top.first_of_line = 1;
+			empty_first_of_line = 0;
+		}
+
 		struct define *def = NULL;
-		if (top.type != T_IDENT || string_set_contains(top.hs, top.str) ||
-			builtin_macros(&top) || !(def = define_map_get(top.str))) {
+		if (top.type != T_IDENT || hide_set_contains(top.hs, top.spelling) ||
+			builtin_macros(&top) || !(def = define_map_get(top.spelling))) {
+			if (macro_report_enabled && final)
+				macro_report_output();
+
 			if (return_output) {
 				*t = top;
 				return;
@@ -507,8 +591,13 @@ void expand_buffer(int input, int return_output, struct token *t) {
 
 		if ((def->func && (input || input_buffer.size) && input_buffer_top(input)->type == T_LPAR) ||
 			!def->func) {
-			subs_buffer(top, def, &top.hs, top.pos, input);
+			if (macro_report_enabled)
+				macro_report_begin(def);
+			subs_buffer(top, def, &top.hs, top.loc, input);
 		} else {
+			if (macro_report_enabled && final)
+				macro_report_output();
+
 			if (return_output) {
 				*t = top;
 				return;
@@ -523,9 +612,22 @@ void expand_buffer(int input, int return_output, struct token *t) {
 		*t = (struct token) { .type = T_EOI };
 }
 
+// Expands until empty token. Final is not set when expanding arguments,
+// whose output is expanded again.
+void expand_buffer(int input, int return_output, int final, struct token *t) {
+	if (!macro_report_enabled) {
+		expand(input, return_output, final, t);
+		return;
+	}
+
+	macro_report_enter();
+	expand(input, return_output, final, t);
+	macro_report_leave();
+}
+
 struct token expander_next(void) {
 	struct token t;
-	expand_buffer(1, 1, &t);
+	expand_buffer(1, 1, 1, &t);
 
 	return t;
 }
@@ -539,7 +641,7 @@ void expand_token_list(struct token_list *ts) {
 	}
 
 	size_t output_pos = output_buffer.size;
-	expand_buffer(0, 0, NULL);
+	expand_buffer(0, 0, 1, NULL);
 
 	ts->size = 0;
 	for (unsigned i = output_pos; i < output_buffer.size; i++) {
@@ -5,8 +5,9 @@
 #include "token_list.h"
 
 struct define {
-	struct define *next;
-	struct string_view name;
+	uint32_t name; // Interned.
+	uint32_t loc; // Location of the name in #define, 0 if not from a file.
+	int stats; // Index + 1 in the macro report, 0 if not yet expanded.
 	int func;
 	int vararg;
 
@@ -14,13 +15,16 @@ struct define {
 };
 
 void define_string(char *name, char *value);
-struct define define_init(struct string_view name);
+struct define define_init(uint32_t name);
 void define_add_def(struct define *d, struct token t);
 void define_add_par(struct define *d, struct token t);
 
 void define_map_add(struct define def);
-struct define *define_map_get(struct string_view str);
-void define_map_remove(struct string_view name);
+struct define *define_map_get(uint32_t name);
+void define_map_remove(uint32_t name);
+
+typedef void (*define_map_function)(struct define *def, void *data);
+void define_map_for_each(define_map_function f, void *data);
 
 struct token expander_next(void);
 
@@ -0,0 +1,162 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "macro_report.h"
+#include "macro_expander.h"
+
+#include <common.h>
+#include <intern.h>
+
+#include <string.h>
+#include <time.h>
+
+int macro_report_enabled = 0;
+int macro_report_limit = 20;
+
+struct macro_stats {
+	uint32_t name, loc;
+	size_t expansions, tokens;
+	double time;
+};
+
+static size_t stats_size, stats_cap;
+static struct macro_stats *stats;
+
+// Expansions that are still being rescanned, innermost last.
+struct frame {
+	size_t stats, input_start;
+	int substituting; // The replacement list is not yet pushed.
+	size_t start_tokens;
+	double start_time;
+};
+
+static size_t frames_size, frames_cap;
+static struct frame *frames;
+
+// Time spent in the expander, and tokens output by it. The clock is only
+// read while there are expansions to time.
+static int depth, timing;
+static double expander_time, entered_time;
+static size_t output_tokens;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Only called inside the expander.
+static double current_time(void) {
+	if (!timing) {
+		timing = 1;
+		entered_time = now();
+		return expander_time;
+	}
+	return expander_time + now() - entered_time;
+}
+
+void macro_report_enter(void) {
+	if (depth++ == 0 && frames_size) {
+		timing = 1;
+		entered_time = now();
+	}
+}
+
+void macro_report_leave(void) {
+	if (--depth == 0 && timing) {
+		expander_time += now() - entered_time;
+		timing = 0;
+	}
+}
+
+void macro_report_begin(struct define *def) {
+	if (!def->stats) {
+		ADD_ELEMENT(stats_size, stats_cap, stats) = (struct macro_stats) {
+			.name = def->name,
+			.loc = def->loc,
+		};
+		def->stats = stats_size;
+	}
+
+	stats[def->stats - 1].expansions++;
+
+	ADD_ELEMENT(frames_size, frames_cap, frames) = (struct frame) {
+		.stats = def->stats - 1,
+		.substituting = 1,
+		.start_tokens = output_tokens,
+		.start_time = current_time(),
+	};
+}
+
+void macro_report_substituted(size_t input_start) {
+	if (!frames_size || !frames[frames_size - 1].substituting)
+		ICE("Macro report expansions out of order.");
+
+	frames[frames_size - 1].substituting = 0;
+	frames[frames_size - 1].input_start = input_start;
+}
+
+void macro_report_take(size_t input_size) {
+	double time = 0;
+	while (frames_size && !frames[frames_size - 1].substituting &&
+		   frames[frames_size - 1].input_start >= input_size) {
+		struct frame *frame = &frames[--frames_size];
+
+		if (!time)
+			time = current_time();
+
+		stats[frame->stats].tokens += output_tokens - frame->start_tokens;
+		stats[frame->stats].time += time - frame->start_time;
+	}
+}
+
+void macro_report_output(void) {
+	output_tokens++;
+}
+
+static int compare_stats(const void *a, const void *b) {
+	const struct macro_stats *sa = a, *sb = b;
+	if (sa->tokens != sb->tokens)
+		return sa->tokens < sb->tokens ? 1 : -1;
+	if (sa->expansions != sb->expansions)
+		return sa->expansions < sb->expansions ? 1 : -1;
+	return 0;
+}
+
+void macro_report_print(const char *path) {
+	if (!macro_report_enabled)
+		return;
+
+	// Defines refer to their stats by index, so a copy is sorted.
+	struct macro_stats *sorted = cc_malloc(sizeof *sorted * MAX(stats_size, 1));
+	memcpy(sorted, stats, sizeof *sorted * stats_size);
+	qsort(sorted, stats_size, sizeof *sorted, compare_stats);
+
+	size_t n = MIN(stats_size, (size_t)macro_report_limit);
+	fprintf(stderr, "Macro report for %s (top %zu of %zu expanded macros, by output tokens)\n",
+			path, n, stats_size);
+	fprintf(stderr, "%-24s %12s %12s %10s %10s  %s\n", "Macro", "Expansions",
+			"Tokens", "Tokens/use", "Time (s)", "Defined at");
+
+	for (size_t i = 0; i < n; i++) {
+		struct macro_stats *s = &sorted[i];
+		struct string_view name = intern_str(s->name);
+		fprintf(stderr, "%-24.*s %12zu %12zu %10.1f %10.4f  ", name.len, name.str,
+				s->expansions, s->tokens, (double)s->tokens / s->expansions, s->time);
+
+		if (s->loc) {
+			struct position pos = location_resolve(s->loc);
+			fprintf(stderr, "%s:%d\n", pos.path, pos.line);
+		} else {
+			fprintf(stderr, "<built-in>\n");
+		}
+	}
+
+	free(sorted);
+}
+
+void macro_report_reset(void) {
+	stats_size = frames_size = 0;
+	depth = timing = 0;
+	expander_time = 0;
+	output_tokens = 0;
+}
@@ -0,0 +1,33 @@
+#ifndef MACRO_REPORT_H
+#define MACRO_REPORT_H
+
+#include <stddef.h>
+
+// Expansion statistics of each macro definition, for -fmacro-report.
+// An expansion lasts until all tokens of its replacement list have been
+// rescanned, so the output tokens and time of a macro include the macros
+// expanded from it, and from its arguments. Time is only counted while
+// inside the macro expander.
+
+struct define;
+
+extern int macro_report_enabled;
+extern int macro_report_limit; // Number of macros printed.
+
+// Called when entering and leaving expand_buffer.
+void macro_report_enter(void);
+void macro_report_leave(void);
+
+// Called before substituting def, and after its replacement list has been
+// pushed to the input buffer above input_start.
+void macro_report_begin(struct define *def);
+void macro_report_substituted(size_t input_start);
+// Ends the expansions whose tokens have all been taken from the input buffer.
+void macro_report_take(size_t input_size);
+// A token left the expander.
+void macro_report_output(void);
+
+void macro_report_print(const char *path);
+void macro_report_reset(void);
+
+#endif
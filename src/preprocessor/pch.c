@@ -0,0 +1,478 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "pch.h"
+#include "macro_expander.h"
+#include "directives.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <common.h>
+
+// Layout of the file, all integers are native 32 or 64-bit values:
+// magic, key, number of strings, size of strings, size of body,
+// strings: length and bytes of each string, referenced by index from 1,
+//          where 0 is the empty string,
+// body: locations, tokens, macro definitions, dependencies with their size
+//       and modification time, included files.
+// Locations are saved as the positions they resolve to: for each path, the
+// largest column of each line. The reader adds a file of spaces for each
+// path, in which all those positions exist, and tokens refer to offsets in
+// these files, from 1, where 0 is no location.
+static const char magic[8] = { 'C', 'C', 'P', 'C', 'H', 0, 0, 3 };
+
+struct buffer {
+	size_t size, cap;
+	uint8_t *data;
+};
+
+static void buffer_write(struct buffer *buffer, const void *data, size_t size) {
+	if (buffer->size + size > buffer->cap) {
+		buffer->cap = MAX(buffer->cap * 2, buffer->size + size);
+		buffer->data = cc_realloc(buffer->data, buffer->cap);
+	}
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+}
+
+static void buffer_u32(struct buffer *buffer, uint32_t value) {
+	buffer_write(buffer, &value, sizeof value);
+}
+
+static void buffer_u64(struct buffer *buffer, uint64_t value) {
+	buffer_write(buffer, &value, sizeof value);
+}
+
+static struct buffer strings, body;
+static uint32_t n_strings;
+
+// Index of each interned string in strings, 0 if not yet written.
+static size_t string_index_cap;
+static uint32_t *string_index;
+
+static uint32_t string_ref(uint32_t id) {
+	if (!id)
+		return 0;
+
+	if (id >= string_index_cap) {
+		size_t new_cap = MAX(string_index_cap * 2, 1024);
+		while (new_cap <= id)
+			new_cap *= 2;
+		string_index = cc_realloc(string_index, sizeof *string_index * new_cap);
+		memset(string_index + string_index_cap, 0, sizeof *string_index * (new_cap - string_index_cap));
+		string_index_cap = new_cap;
+	}
+
+	if (!string_index[id]) {
+		struct string_view str = intern_str(id);
+		buffer_u32(&strings, str.len);
+		buffer_write(&strings, str.str, str.len);
+		string_index[id] = ++n_strings;
+	}
+
+	return string_index[id];
+}
+
+static size_t location_paths_size, location_paths_cap;
+static struct location_path {
+	uint32_t path; // Interned.
+	int n_lines, lines_cap;
+	int *widths; // Number of spaces on each line.
+	uint32_t *line_offsets; // Offset of each line among all paths.
+} *location_paths;
+
+static size_t last_location_path;
+
+// Columns count from the preceding newline, see location_resolve, so the
+// first character of a line is column 2.
+static struct location_path *location_path(struct position pos) {
+	if (!pos.path || pos.line < 1)
+		return NULL;
+
+	uint32_t path = intern(sv_from_str((char *)pos.path));
+	if (last_location_path < location_paths_size &&
+		location_paths[last_location_path].path == path)
+		return &location_paths[last_location_path];
+
+	for (last_location_path = 0; last_location_path < location_paths_size; last_location_path++) {
+		if (location_paths[last_location_path].path == path)
+			return &location_paths[last_location_path];
+	}
+
+	ADD_ELEMENT(location_paths_size, location_paths_cap, location_paths) =
+		(struct location_path) { .path = path };
+	return &location_paths[last_location_path];
+}
+
+static void add_location(uint32_t loc) {
+	struct position pos = location_resolve(loc);
+	struct location_path *lp = location_path(pos);
+	if (!lp)
+		return;
+
+	while (lp->n_lines < pos.line)
+		ADD_ELEMENT(lp->n_lines, lp->lines_cap, lp->widths) = 0;
+
+	lp->widths[pos.line - 1] = MAX(lp->widths[pos.line - 1], MAX(pos.column, 2) - 1);
+}
+
+static uint32_t location_ref(uint32_t loc) {
+	struct position pos = location_resolve(loc);
+	struct location_path *lp = location_path(pos);
+	if (!lp)
+		return 0;
+
+	return lp->line_offsets[pos.line - 1] + MAX(pos.column, 2) - 2 + 1;
+}
+
+static void add_token_location(struct token *t) {
+	add_location(t->loc);
+}
+
+static void add_define_locations(struct define *def, void *data) {
+	(void)data;
+	add_location(def->loc);
+	for (int i = 0; i < def->par.size; i++)
+		add_location(def->par.list[i].loc);
+	for (int i = 0; i < def->def.size; i++)
+		add_location(def->def.list[i].loc);
+}
+
+// Offsets of the files are those given by location_add_file to files
+// added one after the other, each using the size of its contents plus one.
+static void write_locations(void) {
+	uint32_t offset = 0;
+	buffer_u32(&body, location_paths_size);
+	for (size_t i = 0; i < location_paths_size; i++) {
+		struct location_path *lp = &location_paths[i];
+		buffer_u32(&body, string_ref(lp->path));
+		buffer_u32(&body, lp->n_lines);
+
+		lp->line_offsets = cc_malloc(sizeof *lp->line_offsets * MAX(lp->n_lines, 1));
+		for (int j = 0; j < lp->n_lines; j++) {
+			buffer_u32(&body, lp->widths[j]);
+			lp->line_offsets[j] = offset;
+			offset += lp->widths[j] + 1;
+		}
+		offset++;
+	}
+}
+
+static void write_token(struct token *t) {
+	buffer_u32(&body, t->type |
+			   t->first_of_line << 8 | t->first_of_line_after << 9 |
+			   t->whitespace << 10 | t->whitespace_after << 11);
+	buffer_u32(&body, string_ref(t->spelling));
+	buffer_u32(&body, location_ref(t->loc));
+}
+
+static void count_define(struct define *def, void *data) {
+	(void)def;
+	(*(uint32_t *)data)++;
+}
+
+static void write_define(struct define *def, void *data) {
+	(void)data;
+	buffer_u32(&body, string_ref(def->name));
+	buffer_u32(&body, location_ref(def->loc));
+	buffer_u32(&body, def->func | def->vararg << 1);
+	buffer_u32(&body, def->par.size);
+	buffer_u32(&body, def->def.size);
+	for (int i = 0; i < def->par.size; i++)
+		write_token(&def->par.list[i]);
+	for (int i = 0; i < def->def.size; i++)
+		write_token(&def->def.list[i]);
+}
+
+void pch_write(const char *path, struct cache_key key,
+			   struct token *tokens, size_t n_tokens) {
+	for (size_t i = 0; i < n_tokens; i++)
+		add_token_location(&tokens[i]);
+	define_map_for_each(add_define_locations, NULL);
+	write_locations();
+
+	buffer_u32(&body, n_tokens);
+	for (size_t i = 0; i < n_tokens; i++)
+		write_token(&tokens[i]);
+
+	uint32_t n_defines = 0;
+	define_map_for_each(count_define, &n_defines);
+	buffer_u32(&body, n_defines);
+	define_map_for_each(write_define, NULL);
+
+	size_t n_deps;
+	char **deps = directiver_get_dependencies(&n_deps);
+	buffer_u32(&body, n_deps);
+	for (size_t i = 0; i < n_deps; i++) {
+		struct stat st;
+		if (stat(deps[i], &st) != 0)
+			ERROR_NO_POS("Could not read %s", deps[i]);
+		buffer_u32(&body, string_ref(intern(sv_from_str(deps[i]))));
+		buffer_u64(&body, st.st_size);
+		buffer_u64(&body, st.st_mtim.tv_sec);
+		buffer_u64(&body, st.st_mtim.tv_nsec);
+	}
+
+	struct input_file_state state;
+	uint32_t n_files = 0;
+	while (input_get_file_state(n_files, &state))
+		n_files++;
+	buffer_u32(&body, n_files);
+	for (uint32_t i = 0; i < n_files; i++) {
+		input_get_file_state(i, &state);
+		buffer_u64(&body, state.dev);
+		buffer_u64(&body, state.ino);
+		buffer_u32(&body, state.once);
+		buffer_u32(&body, string_ref(state.guard));
+	}
+
+	struct buffer header = { 0 };
+	buffer_write(&header, magic, sizeof magic);
+	buffer_u64(&header, key.a);
+	buffer_u64(&header, key.b);
+	buffer_u32(&header, n_strings);
+	buffer_u32(&header, strings.size);
+	buffer_u32(&header, body.size);
+
+	FILE *fp = fopen(path, "wb");
+	if (!fp ||
+		fwrite(header.data, header.size, 1, fp) != 1 ||
+		(strings.size && fwrite(strings.data, strings.size, 1, fp) != 1) ||
+		fwrite(body.data, body.size, 1, fp) != 1)
+		ERROR_NO_POS("Could not write precompiled header %s", path);
+	fclose(fp);
+
+	free(header.data);
+	free(strings.data);
+	free(body.data);
+	free(string_index);
+	strings = body = (struct buffer) { 0 };
+	string_index = NULL;
+	string_index_cap = 0;
+	n_strings = 0;
+
+	for (size_t i = 0; i < location_paths_size; i++) {
+		free(location_paths[i].widths);
+		free(location_paths[i].line_offsets);
+	}
+	free(location_paths);
+	location_paths = NULL;
+	location_paths_size = location_paths_cap = last_location_path = 0;
+}
+
+static uint8_t *map;
+static size_t map_size;
+
+static struct token *tokens;
+
+// Paths and contents of the files added for locations.
+static size_t location_files_size, location_files_cap;
+static char **location_files;
+
+// Location of offset 0 in the files added for locations.
+static uint32_t location_base;
+
+// Interned id of each string index.
+static uint32_t *ids;
+static uint32_t n_ids;
+
+struct reader {
+	const char *path;
+	const uint8_t *pos, *end;
+};
+
+static const uint8_t *read_bytes(struct reader *r, size_t size) {
+	if ((size_t)(r->end - r->pos) < size)
+		ERROR_NO_POS("Invalid precompiled header %s", r->path);
+	const uint8_t *ret = r->pos;
+	r->pos += size;
+	return ret;
+}
+
+static uint32_t read_u32(struct reader *r) {
+	uint32_t value;
+	memcpy(&value, read_bytes(r, sizeof value), sizeof value);
+	return value;
+}
+
+static uint64_t read_u64(struct reader *r) {
+	uint64_t value;
+	memcpy(&value, read_bytes(r, sizeof value), sizeof value);
+	return value;
+}
+
+static uint32_t read_string(struct reader *r) {
+	uint32_t idx = read_u32(r);
+	if (idx > n_ids)
+		ERROR_NO_POS("Invalid precompiled header %s", r->path);
+	return idx ? ids[idx - 1] : 0;
+}
+
+static uint32_t read_location(struct reader *r) {
+	uint32_t ref = read_u32(r);
+	return ref ? location_base + ref - 1 : 0;
+}
+
+static void read_locations(struct reader *r) {
+	uint32_t n_paths = read_u32(r);
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < n_paths; i++) {
+		char *path = sv_to_str(intern_str(read_string(r)));
+		uint32_t n_lines = read_u32(r);
+
+		size_t size = 0, cap = 0;
+		char *contents = NULL;
+		for (uint32_t j = 0; j < n_lines; j++) {
+			uint32_t width = read_u32(r);
+			for (uint32_t k = 0; k < width; k++)
+				ADD_ELEMENT(size, cap, contents) = ' ';
+			ADD_ELEMENT(size, cap, contents) = '\n';
+		}
+		ADD_ELEMENT(size, cap, contents) = '\0';
+
+		uint32_t base = location_add_file(path, contents);
+		if (i == 0)
+			location_base = base;
+		else if (base != location_base + offset)
+			ICE("Locations of precompiled header are not contiguous.");
+		offset += size;
+
+		ADD_ELEMENT(location_files_size, location_files_cap, location_files) = path;
+		ADD_ELEMENT(location_files_size, location_files_cap, location_files) = contents;
+	}
+}
+
+static struct token read_token(struct reader *r) {
+	uint32_t bits = read_u32(r);
+	uint32_t spelling = read_string(r);
+	uint32_t loc = read_location(r);
+
+	if ((bits & 0xff) >= T_COUNT)
+		ERROR_NO_POS("Invalid precompiled header %s", r->path);
+
+	return (struct token) {
+		.type = bits & 0xff,
+		.first_of_line = bits >> 8 & 1,
+		.first_of_line_after = bits >> 9 & 1,
+		.whitespace = bits >> 10 & 1,
+		.whitespace_after = bits >> 11 & 1,
+		.loc = loc,
+		.spelling = spelling,
+	};
+}
+
+struct token *pch_read(const char *path, struct cache_key key, size_t *n_tokens) {
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0)
+		ERROR_NO_POS("Could not open precompiled header %s", path);
+
+	map_size = st.st_size;
+	map = map_size ? mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+	close(fd);
+
+	if (!map || map == MAP_FAILED) {
+		map = NULL;
+		ERROR_NO_POS("Could not map precompiled header %s", path);
+	}
+
+	struct reader r = { path, map, map + map_size };
+
+	if (memcmp(read_bytes(&r, sizeof magic), magic, sizeof magic) != 0)
+		ERROR_NO_POS("%s is not a precompiled header", path);
+
+	uint64_t key_a = read_u64(&r), key_b = read_u64(&r);
+	if (key_a != key.a || key_b != key.b)
+		ERROR_NO_POS("Precompiled header %s was built by another compiler, for another target or with other -D, -U or -I options", path);
+
+	n_ids = read_u32(&r);
+	uint32_t strings_size = read_u32(&r);
+	uint32_t body_size = read_u32(&r);
+
+	struct reader strings_reader = { path, read_bytes(&r, strings_size), r.pos };
+	struct reader body_reader = { path, read_bytes(&r, body_size), r.pos };
+
+	ids = cc_malloc(sizeof *ids * MAX(n_ids, 1));
+	for (uint32_t i = 0; i < n_ids; i++) {
+		uint32_t len = read_u32(&strings_reader);
+		const uint8_t *str = read_bytes(&strings_reader, len);
+		ids[i] = intern((struct string_view) { .len = len, .str = (char *)str });
+	}
+
+	read_locations(&body_reader);
+
+	*n_tokens = read_u32(&body_reader);
+	tokens = cc_malloc(sizeof *tokens * MAX(*n_tokens, 1));
+	for (size_t i = 0; i < *n_tokens; i++)
+		tokens[i] = read_token(&body_reader);
+
+	uint32_t n_defines = read_u32(&body_reader);
+	for (uint32_t i = 0; i < n_defines; i++) {
+		struct define def = define_init(read_string(&body_reader));
+		def.loc = read_location(&body_reader);
+		uint32_t flags = read_u32(&body_reader);
+		uint32_t n_par = read_u32(&body_reader);
+		uint32_t n_def = read_u32(&body_reader);
+
+		for (uint32_t j = 0; j < n_par; j++)
+			define_add_par(&def, read_token(&body_reader));
+		for (uint32_t j = 0; j < n_def; j++)
+			define_add_def(&def, read_token(&body_reader));
+
+		def.func = flags & 1;
+		def.vararg = flags >> 1 & 1;
+		define_map_add(def);
+	}
+
+	// The header is out of date if any of the files it was built from changed.
+	uint32_t n_deps = read_u32(&body_reader);
+	for (uint32_t i = 0; i < n_deps; i++) {
+		char *dep = sv_to_str(intern_str(read_string(&body_reader)));
+		uint64_t size = read_u64(&body_reader);
+		uint64_t mtime_sec = read_u64(&body_reader);
+		uint64_t mtime_nsec = read_u64(&body_reader);
+
+		struct stat dep_st;
+		if (stat(dep, &dep_st) != 0 || (uint64_t)dep_st.st_size != size ||
+			(uint64_t)dep_st.st_mtim.tv_sec != mtime_sec ||
+			(uint64_t)dep_st.st_mtim.tv_nsec != mtime_nsec)
+			ERROR_NO_POS("Precompiled header %s is out of date, %s has changed", path, dep);
+
+		directiver_add_dependency(dep);
+		free(dep);
+	}
+
+	uint32_t n_files = read_u32(&body_reader);
+	for (uint32_t i = 0; i < n_files; i++) {
+		struct input_file_state state;
+		state.dev = read_u64(&body_reader);
+		state.ino = read_u64(&body_reader);
+		state.once = read_u32(&body_reader);
+		state.guard = read_string(&body_reader);
+		input_restore_file_state(state);
+	}
+
+	return tokens;
+}
+
+void pch_reset(void) {
+	if (map)
+		munmap(map, map_size);
+	map = NULL;
+	map_size = 0;
+
+	free(tokens);
+	free(ids);
+	for (size_t i = 0; i < location_files_size; i++)
+		free(location_files[i]);
+	free(location_files);
+	location_files = NULL;
+	location_files_size = location_files_cap = 0;
+	location_base = 0;
+	tokens = NULL;
+	ids = NULL;
+	n_ids = 0;
+}
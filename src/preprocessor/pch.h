@@ -0,0 +1,26 @@
+#ifndef PCH_H
+#define PCH_H
+
+#include "preprocessor.h"
+
+#include <cache.h>
+
+// Precompiled headers, written with -x c-header or --emit-pch, and read
+// with -include-pch.
+// A precompiled header holds the preprocessed tokens of the header, the
+// macros defined at its end, the files it included and their include guards.
+// The key identifies the compiler and target, a header written with another
+// key is rejected. So is a header whose files have changed size or
+// modification time since it was written.
+
+void pch_write(const char *path, struct cache_key key,
+			   struct token *tokens, size_t n_tokens);
+
+// Restores the macros and included files of the header, and returns its
+// tokens. Strings are interned in place in the mapped file, which stays
+// mapped until pch_reset.
+struct token *pch_read(const char *path, struct cache_key key, size_t *n_tokens);
+
+void pch_reset(void);
+
+#endif
@@ -3,18 +3,53 @@
 #include "tokenizer.h"
 #include "string_concat.h"
 #include "macro_expander.h"
+#include "hide_set.h"
+#include "pch.h"
 
 #include <common.h>
+#include <time_report.h>
 #include <assert.h>
 
 static struct token_stream {
 	struct token buffer[3], pushed;
 } ts;
 
+// Tokens of the precompiled header, read before those of the file.
+static struct token *prefix;
+static size_t prefix_size, prefix_pos;
+
+struct token preprocessor_next_raw(void) {
+	if (prefix_pos < prefix_size)
+		return prefix[prefix_pos++];
+	return expander_next();
+}
+
+// Tokens of the whole file, when preprocessed by preprocessor_init_buffered.
+static struct token *buffered;
+static size_t buffered_size, buffered_cap, buffered_pos;
+
+static struct token next_token(void) {
+	if (buffered) {
+		// The last token is T_EOI, which is repeated.
+		if (buffered_pos < buffered_size - 1)
+			return buffered[buffered_pos++];
+		return buffered[buffered_size - 1];
+	}
+
+	time_phase_push(TIME_PREPROCESS);
+	struct token t = string_concat_next();
+	time_phase_pop();
+	return t;
+}
+
 void t_next(void) {
 	ts.buffer[0] = ts.buffer[1];
 	ts.buffer[1] = ts.buffer[2];
-	ts.buffer[2] = ts.pushed.type ? ts.pushed : string_concat_next();
+	if (ts.pushed.type) {
+		ts.buffer[2] = ts.pushed;
+	} else {
+		ts.buffer[2] = next_token();
+	}
 	ts.pushed = (struct token) {0};
 }
 
@@ -34,20 +69,77 @@ void preprocessor_init(const char *path) {
 		t_next();
 }
 
+struct token *preprocessor_init_buffered(const char *path, size_t *n_tokens) {
+	directiver_push_input(path, 0);
+
+	time_phase_push(TIME_PREPROCESS);
+	do {
+		ADD_ELEMENT(buffered_size, buffered_cap, buffered) = string_concat_next();
+	} while (buffered[buffered_size - 1].type != T_EOI);
+	time_phase_pop();
+
+	for (unsigned i = 0; i < sizeof ts.buffer / sizeof *ts.buffer; i++)
+		t_next();
+
+	*n_tokens = buffered_size;
+	return buffered;
+}
+
+void preprocessor_include_pch(const char *path, struct cache_key key) {
+	prefix = pch_read(path, key, &prefix_size);
+	prefix_pos = 0;
+	directiver_add_dependency(path);
+}
+
+void preprocessor_init_raw(const char *path) {
+	directiver_push_input(path, 0);
+}
+
+void preprocessor_write_pch(const char *header, const char *path, struct cache_key key) {
+	directiver_write_dependencies();
+	preprocessor_init_raw(header);
+
+	// The final T_EOI is not stored.
+	size_t n_tokens = 0, cap = 0;
+	struct token *tokens = NULL;
+	for (struct token t = preprocessor_next_raw(); t.type != T_EOI; t = preprocessor_next_raw())
+		ADD_ELEMENT(n_tokens, cap, tokens) = t;
+
+	pch_write(path, key, tokens, n_tokens);
+	free(tokens);
+}
+
 struct token *t_peek(int n) {
 	assert(n <= 2);
 	return &ts.buffer[n];
 }
 
+struct string_view token_str(const struct token *t) {
+	return intern_str(t->spelling);
+}
+
+struct position token_position(const struct token *t) {
+	return location_resolve(t->loc);
+}
+
 void preprocessor_reset(void) {
+	free(buffered);
+	buffered = NULL;
+	buffered_size = buffered_cap = buffered_pos = 0;
+	prefix = NULL;
+	prefix_size = prefix_pos = 0;
+	pch_reset();
 	directiver_reset();
 	input_reset();
+	location_reset();
+	hide_set_reset();
+	string_concat_reset();
 	macro_expander_reset();
 }
 
 void define_remove(const char *name) {
 	// This is a safe (char *) cast, it will not be modified.
-	define_map_remove(sv_from_str((char *)name));
+	define_map_remove(intern(sv_from_str((char *)name)));
 }
 
 void preprocessor_write_dependencies(void) {
@@ -57,3 +149,17 @@ void preprocessor_write_dependencies(void) {
 void preprocessor_finish_writing_dependencies(const char *mt, const char *mf) {
 	directiver_finish_writing_dependencies(mt, mf);
 }
+
+void preprocessor_scan_dependencies(const char *path, int skip_system) {
+	directiver_write_dependencies();
+	if (skip_system)
+		directiver_skip_system_dependencies();
+
+	// Only directives are evaluated, other lines are not macro expanded.
+	directiver_push_input(path, 0);
+	while (directiver_next().type != T_EOI);
+}
+
+void preprocessor_print_dependencies(FILE *fp, const char *mt) {
+	directiver_print_dependencies(fp, mt);
+}
@@ -2,7 +2,8 @@
 #define PREPROCESSOR_H
 
 #include "input.h"
-#include "string_set.h"
+#include <intern.h>
+#include <cache.h>
 
 #include <string_view.h>
 
@@ -23,22 +24,25 @@ enum {
 	T_COUNT
 };
 
+// Tokens are copied by value through the whole preprocessor, and are kept
+// at 16 bytes.
 struct token {
-    ttype type;
+	ttype type;
 
-	struct string_view str;
+	unsigned first_of_line : 1, first_of_line_after : 1;
+	unsigned whitespace : 1, whitespace_after : 1;
 
-    int first_of_line, first_of_line_after;
-    int whitespace, whitespace_after;
-
-	struct position pos;
-
-    struct string_set hs; // Hide set. Only unsed internally.
+	uint32_t loc; // See location_resolve.
+	uint32_t spelling; // Interned id of the string.
+	uint32_t hs; // Hide set handle. Only used internally.
 };
 
+struct string_view token_str(const struct token *t);
+struct position token_position(const struct token *t);
+
 #define EXPECT(T0, ETYPE) do {											\
 	if ((T0)->type != ETYPE) {											\
-		ERROR((T0)->pos, "Got %s expected %s\n", strdup(dbg_token((T0))), dbg_token_type(ETYPE)); \
+		ERROR(token_position(T0), "Got %s expected %s\n", strdup(dbg_token((T0))), dbg_token_type(ETYPE)); \
 			  }															\
 	} while (0)
 
@@ -55,12 +59,31 @@ void t_push(struct token t);
 struct token *t_peek(int n);
 
 void preprocessor_init(const char *path);
+// Preprocesses the whole file up front, t_next then reads the returned
+// tokens. Used when the token stream itself is needed, as for -fcache-dir.
+struct token *preprocessor_init_buffered(const char *path, size_t *n_tokens);
 void preprocessor_reset(void);
 
+// Starts reading the file without t_next, for -E. Tokens are then read
+// with preprocessor_next_raw, before string literals are concatenated and
+// decoded.
+void preprocessor_init_raw(const char *path);
+struct token preprocessor_next_raw(void);
+
+// Reads the precompiled header at path, must be called before
+// preprocessor_init.
+void preprocessor_include_pch(const char *path, struct cache_key key);
+// Preprocesses header and writes it as a precompiled header to path.
+void preprocessor_write_pch(const char *header, const char *path, struct cache_key key);
+
 void define_string(char *name, char *value); // Defined in macro_expander.c
 void define_remove(const char *name);
 
 void preprocessor_write_dependencies(void);
 void preprocessor_finish_writing_dependencies(const char *mt, const char *mf);
 
+// Records the files included by path, for -M and -MM.
+void preprocessor_scan_dependencies(const char *path, int skip_system);
+void preprocessor_print_dependencies(FILE *fp, const char *mt);
+
 #endif
@@ -8,17 +8,82 @@
 
 #include <assert.h>
 
-static ttype get_ident(struct string_view str) {
+static const struct keyword {
+	ttype type;
+	int len;
+	const char *str;
+} keywords[] = {
 #define X(A, B)
 #define SYM(A, B)
-#define KEY(A, B) if(sv_string_cmp(str, B)) { return A; }
+#define KEY(A, B) { A, sizeof B - 1, B },
 #include "tokens.h"
 #undef KEY
 #undef X
 #undef SYM
+};
+
+#define N_KEYWORDS ((int)(sizeof keywords / sizeof *keywords))
+#define KEYWORD_BUCKETS 128
+
+// Keywords chained in buckets keyed on length and first character.
+// Values are indices into keywords plus one, 0 ends the chain.
+static unsigned char keyword_buckets[KEYWORD_BUCKETS], keyword_next[N_KEYWORDS];
+
+static int keyword_bucket(int len, char first) {
+	return ((unsigned char)first * 8 + len) % KEYWORD_BUCKETS;
+}
+
+static void keyword_init(void) {
+	for (int i = N_KEYWORDS - 1; i >= 0; i--) {
+		int bucket = keyword_bucket(keywords[i].len, keywords[i].str[0]);
+		keyword_next[i] = keyword_buckets[bucket];
+		keyword_buckets[bucket] = i + 1;
+	}
+}
+
+static ttype get_ident(struct string_view str) {
+	static int initialized = 0;
+	if (!initialized) {
+		keyword_init();
+		initialized = 1;
+	}
+
+	for (int i = keyword_buckets[keyword_bucket(str.len, str.str[0])]; i; i = keyword_next[i - 1]) {
+		const struct keyword *k = &keywords[i - 1];
+		if (k->len == str.len && memcmp(k->str, str.str, str.len) == 0)
+			return k->type;
+	}
+
 	return T_IDENT;
 }
 
+// Token type of each interned identifier, looked up once per id.
+// 0 means not yet looked up, otherwise the type plus one.
+static size_t ident_types_cap = 0;
+static ttype *ident_types = NULL;
+
+static ttype get_ident_type(uint32_t id) {
+	if (id >= ident_types_cap) {
+		size_t new_cap = MAX(ident_types_cap * 2, 1024);
+		while (new_cap <= id)
+			new_cap *= 2;
+		ident_types = cc_realloc(ident_types, sizeof *ident_types * new_cap);
+		memset(ident_types + ident_types_cap, 0, sizeof *ident_types * (new_cap - ident_types_cap));
+		ident_types_cap = new_cap;
+	}
+
+	if (!ident_types[id])
+		ident_types[id] = get_ident(intern_str(id)) + 1;
+
+	return ident_types[id] - 1;
+}
+
+void string_concat_reset(void) {
+	free(ident_types);
+	ident_types = NULL;
+	ident_types_cap = 0;
+}
+
 enum string_type {
 	STRING_DEFAULT, STRING_U_SMALL, STRING_U_LARGE, STRING_L, STRING_U8
 };
@@ -36,11 +101,8 @@ static void buffer_write(char c) {
 	ADD_ELEMENT(buffer_size, buffer_cap, buffer) = c;
 }
 
-static struct string_view buffer_get(void) {
-	struct string_view ret = { .len = buffer_size };
-	ret.str = cc_malloc(buffer_size);
-	memcpy(ret.str, buffer, buffer_size);
-	return ret;
+static uint32_t buffer_get(void) {
+	return intern_copy((struct string_view) { .len = buffer_size, .str = buffer });
 }
 
 static uint32_t take_utf8(struct string_view *input) {
@@ -139,7 +201,7 @@ struct token string_concat_next(void) {
 		return ret;
 	}
 
-	struct token t = expander_next();
+	struct token t = preprocessor_next_raw();
 	static size_t string_tokens_size = 0, string_tokens_cap = 0;
 	static struct token *string_tokens = NULL;
 
@@ -147,7 +209,7 @@ struct token string_concat_next(void) {
 
 	while (t.type == T_STRING) {
 		ADD_ELEMENT(string_tokens_size, string_tokens_cap, string_tokens) = t;
-		t = expander_next();
+		t = preprocessor_next_raw();
 	}
 
 	if (string_tokens_size) {
@@ -155,7 +217,8 @@ struct token string_concat_next(void) {
 
 		enum string_type combined_type = STRING_DEFAULT;
 		for (unsigned i = 0; i < string_tokens_size; i++) {
-			enum string_type type = take_string_prefix(&string_tokens[i].str);
+			struct string_view str = token_str(&string_tokens[i]);
+			enum string_type type = take_string_prefix(&str);
 
 			if (type == STRING_DEFAULT ||
 				type == combined_type)
@@ -164,12 +227,15 @@ struct token string_concat_next(void) {
 			if (combined_type == STRING_DEFAULT)
 				combined_type = type;
 			else
-				ERROR(string_tokens[i].pos, "Invalid combination of strings with different prefix.");
+				ERROR(token_position(&string_tokens[i]), "Invalid combination of strings with different prefix.");
 		}
 
 		buffer_start();
-		for (unsigned i = 0; i < string_tokens_size; i++)
-			escape_string_to_buffer(string_tokens[i].str, combined_type);
+		for (unsigned i = 0; i < string_tokens_size; i++) {
+			struct string_view str = token_str(&string_tokens[i]);
+			take_string_prefix(&str);
+			escape_string_to_buffer(str, combined_type);
+		}
 		struct token ret = string_tokens[0];
 
 		switch (combined_type) {
@@ -199,21 +265,22 @@ struct token string_concat_next(void) {
 			break;
 		}
 
-		ret.str = buffer_get();
+		ret.spelling = buffer_get();
 		return ret;
 	}
 
 	if (t.type == T_IDENT) {
-		t.type = get_ident(t.str);
+		t.type = get_ident_type(t.spelling);
 	} else if (t.type == T_CHARACTER_CONSTANT) {
-		enum string_type type = take_string_prefix(&t.str);
+		struct string_view str = token_str(&t);
+		enum string_type type = take_string_prefix(&str);
 
 		if (type == STRING_U8)
-			ERROR(t.pos, "Can't have character constant with u8 prefix.");
+			ERROR(token_position(&t), "Can't have character constant with u8 prefix.");
 
 		buffer_start();
-		escape_string_to_buffer(t.str, type);
-		t.str = buffer_get();
+		escape_string_to_buffer(str, type);
+		t.spelling = buffer_get();
 
 		switch (type) {
 		case STRING_DEFAULT:
@@ -236,9 +303,10 @@ struct token string_concat_next(void) {
 }
 
 intmax_t escaped_character_constant_to_int(struct token t) {
-	enum string_type type = take_string_prefix(&t.str);
+	struct string_view str = token_str(&t);
+	enum string_type type = take_string_prefix(&str);
 	buffer_start();
-	escape_string_to_buffer(t.str, type);
+	escape_string_to_buffer(str, type);
 
 	// No need to call buffer_get(), since we do not need
 	// a permanent string_view.
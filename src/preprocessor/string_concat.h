@@ -9,4 +9,6 @@ struct token string_concat_next(void);
 // non-escaped character constants.
 intmax_t escaped_character_constant_to_int(struct token t);
 
+void string_concat_reset(void);
+
 #endif
@@ -1,18 +1,21 @@
 #include "token_list.h"
 
 #include <common.h>
+#include <mem_report.h>
 
 void token_list_free(struct token_list *list) {
 	free(list->list);
 }
 
 void token_list_add(struct token_list *list, struct token t) {
+	enum mem_tag prev_tag = mem_tag_set(MEM_TOKEN_LIST);
 	ADD_ELEMENT(list->size, list->cap, list->list) = t;
+	mem_tag_set(prev_tag);
 }
 
 int token_list_index_of(struct token_list *list, struct token t) {
 	for (int i = 0; i < list->size; i++) {
-		if (sv_cmp(list->list[i].str, t.str)) return i;
+		if (list->list[i].spelling == t.spelling) return i;
 	}
 	return -1;
 }
@@ -5,10 +5,13 @@
 #include <utf8.h>
 
 #include <limits.h>
+#include <stdint.h>
 
+// State of the active tokenizer, loaded from and stored back to struct
+// tokenizer around each call to tokenizer_next.
 static char c;
-static struct position pos;
-static const char *str;
+static const char *str, *contents_start;
+static uint32_t location_base;
 static int needs_escape_sequences_removed, needs_digit_separator_removed;
 
 enum {
@@ -22,7 +25,7 @@ enum {
 };
 
 static char eq_table[UCHAR_MAX + 1] = {
-	1, 2,  2,  2,  2, 2,   2,  2,  2,  7,  10, 2,   2,   7,   2,   2,
+	1, 2,  2,  2,  2, 2,   2,  2,  2,  7,  10, 7,   7,   7,   2,   2,
 	2, 2,  2,  2,  2, 2,   2,  2,  2,  2,  2,  2,   2,   2,   2,   2,
 	7, 33, 34, 35, 9, 37,  38, 39, 40, 41, 42, 43,  44,  45,  46,  47,
 	5, 5,  5,  5,  5, 5,   5,  5,  56, 5,  58, 59,  60,  61,  62,  63,
@@ -37,26 +40,80 @@ static void next_char(void) {
 	if (*str == '\\' &&
 	    (str[1] == '\n' || (str[1] == '\r' && str[2] == '\n'))) {
 		str += str[1] == '\n' ? 2 : 3;
-		pos.line++;
-		pos.column = 0;
 		needs_escape_sequences_removed = 1;
 		next_char();
 		return;
 	}
 
-	if (*str == '\n') {
-		pos.line++;
-		pos.column = 0;
+	c = eq_table[(unsigned char)*str++];
+}
+
+// Word at a time scanning. Words are read aligned, and the input is zero
+// terminated, so a read never crosses into a page past the end.
+#define ONES 0x0101010101010101ull
+#define HIGHS 0x8080808080808080ull
+
+// Nonzero if any byte of x is zero.
+#define HAS_ZERO_BYTE(x) (((x) - ONES) & ~(x) & HIGHS)
+
+static int is_stop(const char *s, char a, char b) {
+	return *s == a || *s == b || *s == '\\' || *s == '\0';
+}
+
+// Returns the first of a, b, '\\' or '\0' from s. Backslashes are
+// stops so that next_char handles line splices.
+static const char *skip_until(const char *s, char a, char b) {
+	while (((uintptr_t)s & 7) && !is_stop(s, a, b))
+		s++;
+
+	if (!((uintptr_t)s & 7)) {
+		uint64_t mask_a = ONES * (unsigned char)a, mask_b = ONES * (unsigned char)b;
+		uint64_t mask_backslash = ONES * '\\';
+		for (;;) {
+			uint64_t w;
+			memcpy(&w, s, sizeof w);
+			uint64_t x = w ^ mask_a, y = w ^ mask_b, z = w ^ mask_backslash;
+			if (HAS_ZERO_BYTE(w) | HAS_ZERO_BYTE(x) | HAS_ZERO_BYTE(y) | HAS_ZERO_BYTE(z))
+				break;
+			s += 8;
+		}
 	}
 
-	pos.column++;
+	while (!is_stop(s, a, b))
+		s++;
+	return s;
+}
 
-	c = eq_table[(unsigned char)*str++];
+// Returns the first byte from s that is not a space.
+static const char *skip_spaces(const char *s) {
+	while (((uintptr_t)s & 7) && *s == ' ')
+		s++;
+
+	if (!((uintptr_t)s & 7)) {
+		for (;;) {
+			uint64_t w;
+			memcpy(&w, s, sizeof w);
+			if (w != ONES * ' ')
+				break;
+			s += 8;
+		}
+	}
+
+	while (*s == ' ')
+		s++;
+	return s;
 }
 
+// Location of the current character c.
+static uint32_t current_location(void) {
+	return location_base + (str - 1 - contents_start);
+}
+
+#define CURRENT_POS (location_resolve(current_location()))
+
 static struct string_view remove_escape_sequences(const char *initial_pos) {
 	size_t len = str - initial_pos - 1;
-	char *ret_str = cc_malloc(len + 1);
+	char *ret_str = arena_alloc(&preprocessor_arena, len + 1);
 	memcpy(ret_str, initial_pos, len);
 	ret_str[len] = '\0';
 
@@ -86,7 +143,7 @@ static struct string_view remove_escape_sequences(const char *initial_pos) {
 				else if (c >= 'A' && c <= 'F')
 					codepoint |= c - 'A' + 10;
 				else
-					ERROR(pos, "Invalid universal character name in %.*s", len,
+					ERROR(CURRENT_POS, "Invalid universal character name in %.*s", len,
 					      initial_pos);
 			}
 
@@ -105,7 +162,7 @@ static struct string_view remove_escape_sequences(const char *initial_pos) {
 
 static struct string_view remove_digit_separator(const char *initial_pos) {
 	size_t len = str - initial_pos - 1;
-	char *ret_str = cc_malloc(len + 1);
+	char *ret_str = arena_alloc(&preprocessor_arena, len + 1);
 	memcpy(ret_str, initial_pos, len);
 	ret_str[len] = '\0';
 
@@ -134,7 +191,7 @@ static void parse_number(void) {
 				needs_digit_separator_removed = 1;
 				next_char();
 			} else {
-				ERROR(pos, "Expected digit or non-digit after ' separator.");
+				ERROR(CURRENT_POS, "Expected digit or non-digit after ' separator.");
 			}
 		} else if (c == EQ_DECIMAL || c == '8' || c == EQ_ALPHA || c == 'u' ||
 		           c == 'U' || c == EQ_EXPONENT || c == 'L' || c == '.') {
@@ -147,7 +204,11 @@ static void parse_number(void) {
 
 static void parse_string_like(char end_char) {
 	while (c != '\n' && c != end_char && c != EQ_NULL) {
-		if (c == '\\') {
+		if (c != '\\') {
+			// Nothing but the current character needs to be looked at
+			// before the next end, newline or backslash.
+			str = skip_until(str, end_char, '\n');
+		} else {
 			next_char();
 			if (c == 'u' || c == 'U') {
 				next_char();
@@ -159,7 +220,7 @@ static void parse_string_like(char end_char) {
 	}
 
 	if (c != end_char)
-		ERROR(pos, "Invalid string");
+		ERROR(CURRENT_POS, "Invalid string");
 
 	next_char();
 }
@@ -181,7 +242,7 @@ static void parse_identifier(void) {
 	}
 }
 
-static struct token tokenizer_next(int *is_header, int *is_directive) {
+static struct token scan_token(int *is_header, int *is_directive) {
 	struct token next = {0};
 
 #define TYPE(IDX) \
@@ -189,7 +250,7 @@ static struct token tokenizer_next(int *is_header, int *is_directive) {
 	next.type = IDX;
 
 restart:
-	next.pos = pos;
+	next.loc = current_location();
 
 	const char *initial_pos = str - 1;
 	needs_escape_sequences_removed = 0;
@@ -197,6 +258,7 @@ restart:
 
 	switch (c) {
 	case EQ_SPACE:
+		str = skip_spaces(str);
 		next_char();
 		next.whitespace = 1;
 		goto restart;
@@ -211,23 +273,28 @@ restart:
 		TYPE(T_DIV);
 		switch (c) {
 		case '/':
-			while (c != '\n' && c != EQ_NULL)
+			while (c != '\n' && c != EQ_NULL) {
+				str = skip_until(str, '\n', '\n');
 				next_char();
+			}
 			next.whitespace = 1;
 			goto restart;
 
 		case '*':
+			next_char();
 			for (;;) {
-				next_char();
 				if (c == '*') {
 					next_char();
 					if (c == '/') {
 						next_char();
 						break;
 					}
+					continue;
 				} else if (c == EQ_NULL) {
-					ERROR(pos, "Comment reached end of file");
+					ERROR(CURRENT_POS, "Comment reached end of file");
 				}
+				str = skip_until(str, '*', '*');
+				next_char();
 			}
 			next.whitespace = 1;
 			goto restart;
@@ -325,7 +392,7 @@ restart:
 		case '.':
 			next_char();
 			if (c != '.')
-				ERROR(pos, "Invalid token");
+				ERROR(CURRENT_POS, "Invalid token");
 			TYPE(T_ELLIPSIS);
 			break;
 		}
@@ -462,55 +529,72 @@ restart:
 		next.type = T_EOI;
 		break;
 
-	default: ERROR(next.pos, "Invalid token");
+	default: ERROR(location_resolve(next.loc), "Invalid token");
 	}
 
-	next.str = (struct string_view){
+	struct string_view spelling = {
 		.len = str - initial_pos - 1,
 		.str = (char *)initial_pos,
 	};
 
 	if (needs_escape_sequences_removed)
-		next.str = remove_escape_sequences(initial_pos);
+		spelling = remove_escape_sequences(initial_pos);
 
 	if (needs_digit_separator_removed)
-		next.str = remove_digit_separator(initial_pos);
+		spelling = remove_digit_separator(initial_pos);
+
+	next.spelling = intern(spelling);
 
 	if (next.type == T_IDENT && *is_directive) {
-		*is_header = sv_string_cmp(next.str, "include");
+		*is_header = sv_string_cmp(spelling, "include");
 		*is_directive = 0;
 	}
 
 	return next;
 }
 
-struct token_list tokenize_input(const char *contents, const char *path) {
-	struct token_list tl = {0};
+static void tokenizer_load(struct tokenizer *tokenizer) {
+	c = tokenizer->c;
+	str = tokenizer->str;
+	contents_start = tokenizer->contents_start;
+	location_base = tokenizer->location_base;
+}
 
-	int is_header = 0, is_directive = 0;
+static void tokenizer_store(struct tokenizer *tokenizer) {
+	tokenizer->c = c;
+	tokenizer->str = str;
+}
 
-	c = '\n'; // Needs to start with newline.
-	pos.path = path;
-	pos.column = 1;
-	pos.line = 1;
-	str = contents;
+void tokenizer_init(struct tokenizer *tokenizer, const char *contents, const char *path) {
+	*tokenizer = (struct tokenizer) {
+		.c = '\n', // Needs to start with newline.
+		.str = contents,
+		.contents_start = contents,
+		.location_base = location_add_file(path, contents),
+	};
 
 	// Read, and ignore, BOM (byte order mark).
 	// BOM signifies that the text file is utf-8.
 	// It has the form: 0xef 0xbb 0xbf.
-	if ((unsigned char)str[0] == 0xef && (unsigned char)str[1] == 0xbb &&
-	    (unsigned char)str[2] == 0xbf)
-		str += 3;
-
-	struct token t = tokenizer_next(&is_header, &is_directive);
-	while (t.type != T_EOI) {
-		token_list_add(&tl, t);
-		t = tokenizer_next(&is_header, &is_directive);
-
-		struct token *prev = &tl.list[tl.size - 1];
-		prev->whitespace_after = t.whitespace;
-		prev->first_of_line_after = t.first_of_line;
-	}
+	if ((unsigned char)contents[0] == 0xef && (unsigned char)contents[1] == 0xbb &&
+	    (unsigned char)contents[2] == 0xbf)
+		tokenizer->str += 3;
+
+	tokenizer_load(tokenizer);
+	tokenizer->next = scan_token(&tokenizer->is_header, &tokenizer->is_directive);
+	tokenizer_store(tokenizer);
+}
+
+struct token tokenizer_next(struct tokenizer *tokenizer) {
+	struct token t = tokenizer->next;
+	if (t.type == T_EOI)
+		return t;
+
+	tokenizer_load(tokenizer);
+	tokenizer->next = scan_token(&tokenizer->is_header, &tokenizer->is_directive);
+	tokenizer_store(tokenizer);
 
-	return tl;
+	t.whitespace_after = tokenizer->next.whitespace;
+	t.first_of_line_after = tokenizer->next.first_of_line;
+	return t;
 }
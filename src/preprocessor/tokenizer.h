@@ -3,6 +3,18 @@
 
 #include "token_list.h"
 
-struct token_list tokenize_input(const char *contents, const char *path);
+// Tokenizes a file on demand. One token is read ahead, to set
+// whitespace_after and first_of_line_after of the returned token.
+struct tokenizer {
+	const char *str, *contents_start;
+	uint32_t location_base;
+	char c;
+	int is_header, is_directive;
+	struct token next;
+};
+
+void tokenizer_init(struct tokenizer *tokenizer, const char *contents, const char *path);
+// Returns T_EOI at the end of the input, and keeps returning it.
+struct token tokenizer_next(struct tokenizer *tokenizer);
 
 #endif
@@ -0,0 +1,117 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "time_report.h"
+
+#include "common.h"
+
+#include <time.h>
+
+int time_report_enabled = 0;
+
+static const char *phase_names[] = {
+#define X(A, B) B,
+	TIME_PHASES(X)
+#undef X
+};
+
+static struct phase_time totals[TIME_PHASE_COUNT];
+
+#define MAX_DEPTH 16
+static enum time_phase stack[MAX_DEPTH];
+static int depth = 0;
+static struct phase_time last;
+
+static double timespec_to_double(struct timespec ts) {
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void now(struct phase_time *time) {
+	struct timespec wall, cpu;
+	clock_gettime(CLOCK_MONOTONIC, &wall);
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+	time->wall = timespec_to_double(wall);
+	time->cpu = timespec_to_double(cpu);
+}
+
+// Give the time since last push or pop to the innermost phase.
+static void accumulate(void) {
+	struct phase_time current;
+	now(&current);
+
+	if (depth) {
+		totals[stack[depth - 1]].wall += current.wall - last.wall;
+		totals[stack[depth - 1]].cpu += current.cpu - last.cpu;
+	}
+
+	last = current;
+}
+
+void time_phase_push(enum time_phase phase) {
+	if (!time_report_enabled)
+		return;
+
+	if (depth >= MAX_DEPTH)
+		ICE("Too deeply nested time phases.");
+
+	accumulate();
+	stack[depth++] = phase;
+}
+
+void time_phase_pop(void) {
+	if (!time_report_enabled)
+		return;
+
+	if (!depth)
+		ICE("Unbalanced time phases.");
+
+	accumulate();
+	depth--;
+}
+
+const char *time_phase_name(enum time_phase phase) {
+	return phase_names[phase];
+}
+
+void time_report_get(struct phase_time out[TIME_PHASE_COUNT]) {
+	for (int i = 0; i < TIME_PHASE_COUNT; i++)
+		out[i] = totals[i];
+}
+
+void time_report_add(const struct phase_time in[TIME_PHASE_COUNT]) {
+	for (int i = 0; i < TIME_PHASE_COUNT; i++) {
+		totals[i].wall += in[i].wall;
+		totals[i].cpu += in[i].cpu;
+	}
+}
+
+void time_report_print(FILE *fp) {
+	struct phase_time sum = { 0 };
+	for (int i = 0; i < TIME_PHASE_COUNT; i++) {
+		sum.wall += totals[i].wall;
+		sum.cpu += totals[i].cpu;
+	}
+
+	fprintf(fp, "%-22s %10s %10s %7s\n", "Phase", "Wall (s)", "CPU (s)", "Wall %");
+	for (int i = 0; i < TIME_PHASE_COUNT; i++) {
+		fprintf(fp, "%-22s %10.4f %10.4f %6.1f%%\n", phase_names[i],
+				totals[i].wall, totals[i].cpu,
+				sum.wall > 0 ? 100 * totals[i].wall / sum.wall : 0.0);
+	}
+	fprintf(fp, "%-22s %10.4f %10.4f\n", "total", sum.wall, sum.cpu);
+}
+
+void time_report_write_json(const char *path) {
+	FILE *fp = fopen(path, "w");
+	if (!fp)
+		ERROR_NO_POS("Could not open %s for writing.", path);
+
+	fprintf(fp, "{\n\t\"phases\": [\n");
+	for (int i = 0; i < TIME_PHASE_COUNT; i++) {
+		fprintf(fp, "\t\t{ \"name\": \"%s\", \"wall\": %.6f, \"cpu\": %.6f }%s\n",
+				phase_names[i], totals[i].wall, totals[i].cpu,
+				i + 1 < TIME_PHASE_COUNT ? "," : "");
+	}
+	fprintf(fp, "\t]\n}\n");
+
+	fclose(fp);
+}
@@ -0,0 +1,47 @@
+#ifndef TIME_REPORT_H
+#define TIME_REPORT_H
+
+#include <stdio.h>
+
+// Wall and CPU time spent in each phase of the compiler, for -ftime-report.
+// Phases nest, time is only counted for the innermost phase. This is needed
+// since preprocessing happens on demand while parsing.
+
+#define TIME_PHASES(X)								\
+	X(TIME_PREPROCESS, "preprocess")				\
+	X(TIME_PARSE, "parse_into_ir")					\
+	X(TIME_MEM2REG, "optimize_mem2reg")				\
+	X(TIME_PEEPHOLE, "optimize_peephole")			\
+	X(TIME_REMOVE_DEAD, "optimize_remove_dead")		\
+	X(TIME_SCHEDULE_BLOCKS, "ir_schedule_blocks")	\
+	X(TIME_LOCAL_SCHEDULE, "ir_local_schedule")		\
+	X(TIME_CODEGEN, "codegen")						\
+	X(TIME_WRITE_OBJECT, "write_object")			\
+	X(TIME_LINK, "linker_link")						\
+	X(TIME_WRITE_EXECUTABLE, "elf_write_executable")
+
+enum time_phase {
+#define X(A, B) A,
+	TIME_PHASES(X)
+#undef X
+	TIME_PHASE_COUNT
+};
+
+struct phase_time {
+	double wall, cpu;
+};
+
+extern int time_report_enabled;
+
+void time_phase_push(enum time_phase phase);
+void time_phase_pop(void);
+const char *time_phase_name(enum time_phase phase);
+
+// Totals are copied between processes when compiling with -j.
+void time_report_get(struct phase_time totals[TIME_PHASE_COUNT]);
+void time_report_add(const struct phase_time totals[TIME_PHASE_COUNT]);
+
+void time_report_print(FILE *fp);
+void time_report_write_json(const char *path);
+
+#endif
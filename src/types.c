@@ -7,6 +7,8 @@
 
 #include "types.h"
 #include "common.h"
+#include "mem_report.h"
+#include "intern.h"
 #include "parser/expression_to_ir.h"
 #include <abi/abi.h>
 
@@ -104,9 +106,24 @@ static uint32_t type_hash(struct type *type, struct type **children) {
 	return hash;
 }
 
+// Types are allocated in the translation unit arena.
+static struct type **hashtable = NULL;
+static int hashtable_size = 0;
+static size_t n_types;
+
+size_t type_count(void) {
+	return n_types;
+}
+
+void types_reset(void) {
+	free(hashtable);
+	hashtable = NULL;
+	hashtable_size = 0;
+	n_types = 0;
+}
+
 struct type *type_create(struct type *params, struct type **children) {
-	static struct type **hashtable = NULL;
-	static int hashtable_size = 0;
+	enum mem_tag prev_tag = mem_tag_set(MEM_TYPES);
 
 	if (hashtable_size == 0) {
 		hashtable_size = 1024;
@@ -123,10 +140,14 @@ struct type *type_create(struct type *params, struct type **children) {
 	while(first && !compare_types(params, children, first))
 		first = first->next;
 
-	if (first)
+	if (first) {
+		mem_tag_set(prev_tag);
 		return first;
+	}
 
-	struct type *new = cc_malloc(sizeof(*params) + sizeof(*children) * params->n);
+	struct type *new = arena_alloc(&tu_arena, sizeof(*params) + sizeof(*children) * params->n);
+	n_types++;
+	mem_tag_set(prev_tag);
 	*new = *params;
 	if (params->n)
 		memcpy(new->children, children, sizeof(*children) * params->n);
@@ -176,16 +197,73 @@ struct type *type_remove_qualifications(struct type *type) {
 
 // TODO: make this better.
 struct struct_data *register_struct(void) {
-	return cc_malloc(sizeof (struct struct_data));
+	return ARENA_ALLOC(&tu_arena, (struct struct_data) { 0 });
 }
 
 struct enum_data *register_enum(void) {
-	return cc_malloc(sizeof (struct enum_data));
+	return ARENA_ALLOC(&tu_arena, (struct enum_data) { 0 });
+}
+
+// Open addressing with linear probing, at most half full.
+struct member_index {
+	size_t size, cap;
+	struct member_entry {
+		uint32_t name; // 0 is an empty slot.
+		int n, *indices;
+	} *entries;
+};
+
+static struct member_entry *member_index_alloc(size_t cap) {
+	struct member_entry *entries = arena_alloc(&tu_arena, sizeof *entries * cap);
+	memset(entries, 0, sizeof *entries * cap);
+	return entries;
+}
+
+static struct member_entry *member_index_find(struct member_index *index, uint32_t name) {
+	size_t mask = index->cap - 1, idx = intern_hash(name) & mask;
+	while (index->entries[idx].name && index->entries[idx].name != name)
+		idx = (idx + 1) & mask;
+	return &index->entries[idx];
+}
+
+// Adds the members of data, below the fields in path. The first member
+// with a name is kept, as a search in declaration order would find.
+static void member_index_add(struct member_index *index, struct struct_data *data,
+							 int **path, int *path_size, int *path_cap) {
+	for (int i = 0; i < data->n; i++) {
+		struct field *field = &data->fields[i];
+		ADD_ELEMENT(*path_size, *path_cap, *path) = i;
+
+		if (!field->name) {
+			if (field->type->type == TY_STRUCT)
+				member_index_add(index, field->type->struct_data, path, path_size, path_cap);
+		} else if (!member_index_find(index, field->name)->name) {
+			if (2 * (index->size + 1) > index->cap) {
+				struct member_index old = *index;
+				index->cap *= 2;
+				index->entries = member_index_alloc(index->cap);
+				for (size_t j = 0; j < old.cap; j++) {
+					if (old.entries[j].name)
+						*member_index_find(index, old.entries[j].name) = old.entries[j];
+				}
+			}
+
+			struct member_entry *entry = member_index_find(index, field->name);
+			entry->name = field->name;
+			entry->n = *path_size;
+			entry->indices = arena_alloc(&tu_arena, sizeof *entry->indices * *path_size);
+			for (int j = 0; j < *path_size; j++)
+				entry->indices[j] = (*path)[*path_size - 1 - j];
+			index->size++;
+		}
+
+		(*path_size)--;
+	}
 }
 
-int type_search_member(struct type *type, struct string_view name,
+int type_search_member(struct type *type, uint32_t name,
 					   int *n, int **indices) {
-	static int stack_cap = 0, *stack = NULL;
+	static int path_size, path_cap, *path;
 
 	if (type->type != TY_STRUCT)
 		return 0;
@@ -195,21 +273,23 @@ int type_search_member(struct type *type, struct string_view name,
 	if (!data->is_complete)
 		ICE("Member access on incomplete type not allowed");
 
-	for (int i = 0; i < data->n; i++) {
-		if (sv_cmp(data->fields[i].name, name)) {
-			ADD_ELEMENT(*n, stack_cap, stack) = i;
-		} else if (data->fields[i].name.len == 0 &&
-				   type_search_member(data->fields[i].type, name,
-									  n, indices)) {
-			ADD_ELEMENT(*n, stack_cap, stack) = i;
-		} else {
-			continue;
-		}
+	if (!data->member_index) {
+		data->member_index = ARENA_ALLOC(&tu_arena, (struct member_index) {
+				.cap = 16,
+				.entries = member_index_alloc(16),
+			});
 
-		*indices = stack;
-		return 1;
+		path_size = 0;
+		member_index_add(data->member_index, data, &path, &path_size, &path_cap);
 	}
-	return 0;
+
+	struct member_entry *entry = member_index_find(data->member_index, name);
+	if (!entry->name)
+		return 0;
+
+	*n = entry->n;
+	*indices = entry->indices;
+	return 1;
 }
 
 // Make arrays into pointers, and functions into function pointers.
@@ -336,7 +416,7 @@ void type_get_offsets(struct type *type, int index, int *offset, int *bit_offset
 void type_remove_unnamed(struct struct_data *data) {
 	int k = 0;
 	for (int i = 0; i < data->n; i++) {
-		if (data->fields[i].name.len ||
+		if (data->fields[i].name ||
 			data->fields[i].type->type == TY_STRUCT)
 			data->fields[k++] = data->fields[i];
 	}
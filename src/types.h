@@ -104,7 +104,7 @@ struct struct_data {
 
 	int n;
 	struct field {
-		struct string_view name;
+		uint32_t name; // Interned, 0 for unnamed members.
 		struct type *type;
 		int bitfield; // -1 means no bit-field.
 		int offset;
@@ -114,6 +114,11 @@ struct struct_data {
 	int alignment, size;
 
 	int flexible;
+
+	// Names of members, including those inside anonymous structs and
+	// unions, mapped to their paths of field indices. Built on the first
+	// member lookup.
+	struct member_index *member_index;
 };
 
 struct enum_data {
@@ -130,6 +135,8 @@ struct enum_data *register_enum(void);
 // string interning.
 struct type *type_simple(enum simple_type type);
 struct type *type_create(struct type *params, struct type **children);
+size_t type_count(void);
+void types_reset(void);
 struct type *type_pointer(struct type *type);
 struct type *type_array(struct type *type, int length);
 struct type *type_deref(struct type *type);
@@ -141,7 +148,9 @@ struct type *type_remove_qualifications(struct type *type);
 void type_evaluate_vla(struct type *type);
 int type_contains_unevaluated_vla(struct type *type);
 
-int type_search_member(struct type *type, struct string_view name,
+// Indices is set to the path of field indices to the member, innermost
+// first, and n to its length.
+int type_search_member(struct type *type, uint32_t name,
 					   int *n, int **indices);
 
 struct type *type_select(struct type *type, int index);
@@ -0,0 +1,106 @@
+#include "writer.h"
+
+#include "common.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#define WRITER_BUFFER_SIZE (1 << 16)
+
+void writer_init(struct writer *writer, FILE *fp) {
+	*writer = (struct writer) {
+		.fp = fp,
+		.buffer = cc_malloc(WRITER_BUFFER_SIZE),
+	};
+}
+
+void writer_flush(struct writer *writer) {
+	if (writer->size && fwrite(writer->buffer, writer->size, 1, writer->fp) != 1)
+		ICE("Could not write output");
+	writer->size = 0;
+}
+
+void writer_finish(struct writer *writer) {
+	writer_flush(writer);
+	fflush(writer->fp);
+	free(writer->buffer);
+	*writer = (struct writer) { 0 };
+}
+
+void writer_write(struct writer *writer, const char *str, size_t len) {
+	if (writer->size + len > WRITER_BUFFER_SIZE) {
+		writer_flush(writer);
+
+		if (len > WRITER_BUFFER_SIZE) {
+			if (fwrite(str, len, 1, writer->fp) != 1)
+				ICE("Could not write output");
+			return;
+		}
+	}
+
+	memcpy(writer->buffer + writer->size, str, len);
+	writer->size += len;
+}
+
+void writer_char(struct writer *writer, char c) {
+	if (writer->size == WRITER_BUFFER_SIZE)
+		writer_flush(writer);
+	writer->buffer[writer->size++] = c;
+}
+
+void writer_string(struct writer *writer, const char *str) {
+	writer_write(writer, str, strlen(str));
+}
+
+void writer_sv(struct writer *writer, struct string_view str) {
+	writer_write(writer, str.str, str.len);
+}
+
+void writer_int(struct writer *writer, int64_t value) {
+	char digits[24];
+	int pos = sizeof digits;
+
+	uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+	do {
+		digits[--pos] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude);
+
+	if (value < 0)
+		digits[--pos] = '-';
+
+	writer_write(writer, digits + pos, sizeof digits - pos);
+}
+
+void writer_vprintf(struct writer *writer, const char *fmt, va_list args) {
+	va_list args_copy;
+	va_copy(args_copy, args);
+
+	size_t space = WRITER_BUFFER_SIZE - writer->size;
+	int len = vsnprintf(writer->buffer + writer->size, space, fmt, args);
+
+	if (len < 0)
+		ICE("Could not format output");
+
+	if ((size_t)len < space) {
+		writer->size += len;
+	} else {
+		// Did not fit, the partial output is overwritten.
+		writer_flush(writer);
+		if ((size_t)len < WRITER_BUFFER_SIZE) {
+			vsnprintf(writer->buffer, WRITER_BUFFER_SIZE, fmt, args_copy);
+			writer->size = len;
+		} else {
+			vfprintf(writer->fp, fmt, args_copy);
+		}
+	}
+
+	va_end(args_copy);
+}
+
+void writer_printf(struct writer *writer, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	writer_vprintf(writer, fmt, args);
+	va_end(args);
+}
@@ -0,0 +1,33 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#include <string_view.h>
+
+// Buffered text output, used for -E and -S.
+// Output is written to the file in large blocks, and the common fragments
+// are appended without going through printf.
+
+struct writer {
+	FILE *fp;
+	size_t size;
+	char *buffer;
+};
+
+void writer_init(struct writer *writer, FILE *fp);
+// Flushes and frees the buffer, the file is not closed.
+void writer_finish(struct writer *writer);
+void writer_flush(struct writer *writer);
+
+void writer_write(struct writer *writer, const char *str, size_t len);
+void writer_char(struct writer *writer, char c);
+void writer_string(struct writer *writer, const char *str);
+void writer_sv(struct writer *writer, struct string_view str);
+void writer_int(struct writer *writer, int64_t value);
+void writer_vprintf(struct writer *writer, const char *fmt, va_list args);
+void writer_printf(struct writer *writer, const char *fmt, ...);
+
+#endif
@@ -7,6 +7,31 @@ struct T {
 	int c, d;
 } t = {.c = 1, .d = 2};
 
+struct U {
+	int m0, m1, m2, m3, m4, m5, m6, m7, m8, m9;
+	union {
+		long l;
+		struct {
+			int lo, hi;
+		};
+	};
+	struct {
+		union {
+			int x;
+			float f;
+		};
+		int y;
+	};
+	int m10, m11, m12;
+} u = {.hi = 7, .y = 8, .m12 = 9};
+
 int main(void) {
 	assert(t.c == 1 && t.d == 2);
+
+	assert(u.hi == 7 && u.y == 8 && u.m12 == 9 && u.lo == 0);
+	u.l = 0;
+	u.x = 3;
+	u.m9 = 4;
+	struct U *p = &u;
+	assert(p->x == 3 && p->m9 == 4 && p->hi == 0 && p->y == 8);
 }
@@ -0,0 +1,7 @@
+// Unsupported pragmas end at the end of the line.
+#pragma unsupported
+int x = 1;
+
+int f(void) {
+	return x + 2;
+}
@@ -0,0 +1,6 @@
+// The same tokens as pragma.c, but x is part of the pragma.
+#pragma unsupported int x = 1;
+
+int f(void) {
+	return x + 2;
+}
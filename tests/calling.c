@@ -40,6 +40,26 @@ struct T4 ret4(void) {
 	return t;
 }
 
+struct T5 {
+	int x, y, z;
+};
+
+struct T6 {
+	struct T5 a, b;
+	int s;
+};
+
+struct T5 ret5(struct T5 a, int s) {
+	return (struct T5) { a.x * s, a.y * s, a.z * s };
+}
+
+// The second eightbyte of the return value must not overwrite p.
+void update6(struct T6 *p) {
+	p->a = ret5(p->b, p->s);
+	if (p->a.x > 0)
+		p->b.x = 0;
+}
+
 int main(void) {
 	assert(sum_a((struct a) { 1, 2, 3 }) == 6);
 	ret_struct();
@@ -48,4 +68,8 @@ int main(void) {
 	assert(ret3().b == 20);
 
 	assert(ret4().d == 1);
+
+	struct T6 t6 = { { 1, 2, 3 }, { 4, 5, 6 }, 2 };
+	update6(&t6);
+	assert(t6.a.x == 8 && t6.a.y == 10 && t6.a.z == 12 && t6.b.x == 0);
 }
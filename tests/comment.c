@@ -3,6 +3,27 @@
 
 char *str = "a\"/*b";
 
+/* Ends in more than one star **/
+int after_stars = 1;
+
+/***/
+int after_three_stars = 1;
+
+// A spliced line comment \
+int spliced_away = 1;
+
+/* A spliced end of comment *\
+/
+int after_spliced_end = 1;
+
+/* A long comment, longer than a word, with "quotes", 'quotes' and \\ backslashes.
+ * ************************************************************************** */
+char *long_str = "a long string literal, longer than a word, \\ with \"escapes\"";
+
 int main(void) {
 	assert(strcmp(str, "a\"/" "*b") == 0);
+	assert(after_stars && after_three_stars && after_spliced_end);
+	assert(strlen(long_str) == 59);
+	int spliced_away = 0;
+	assert(!spliced_away);
 }
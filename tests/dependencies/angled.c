@@ -0,0 +1,4 @@
+// Angled includes found through -I are not system headers.
+#include <lib.h>
+#include <stddef.h>
+#include "local.h"
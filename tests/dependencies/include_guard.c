@@ -0,0 +1,10 @@
+// Files behind an include guard or #pragma once are not read again, so they
+// are only listed once. Files that are read again are listed each time.
+#include "../include_guard1.h"
+#include "../include_guard1.h"
+#include "../include_guard2.h"
+#include "../include_guard2.h"
+#include "../pragma_once1.h"
+#include "../pragma_once1.h"
+#include "../include_guard3.h"
+#include "../include_guard3.h"
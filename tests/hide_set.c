@@ -0,0 +1,28 @@
+#include <assert.h>
+#include <string.h>
+
+// Examples from section 6.10.3.5 of the standard.
+
+#define STR(X) STR2(X)
+#define STR2(X) #X
+
+#define x 3
+#define f(a) f(x * (a))
+#undef x
+#define x 2
+#define g f
+#define z z[0]
+#define t(a) a
+
+#define REC_A REC_B + 1
+#define REC_B REC_A + 2
+
+int main(void) {
+	assert(strcmp(STR(f(f(z))), "f(2 * (f(2 * (z[0]))))") == 0);
+	assert(strcmp(STR(t(t(g)(0) + t)(1)), "f(2 * (0)) + t(1)") == 0);
+	assert(strcmp(STR(g(x+(3,4)-w)), "f(2 * (2+(3,4)-w))") == 0);
+
+	assert(strcmp(STR(REC_A), "REC_A + 2 + 1") == 0);
+	assert(strcmp(STR(REC_B REC_A), "REC_B + 1 + 2 REC_A + 2 + 1") == 0);
+	return 0;
+}
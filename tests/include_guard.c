@@ -0,0 +1,29 @@
+#include <assert.h>
+
+#include "include_guard1.h"
+#include "include_guard1.h"
+// Same file through another path.
+#include "./include_guard1.h"
+
+#include "pragma_once1.h"
+#include "./pragma_once1.h"
+
+int main(void) {
+	int guarded_count = 0, unguarded_count = 0;
+
+#include "include_guard2.h"
+#include "include_guard2.h"
+	assert(guarded_count == 1);
+
+#undef INCLUDE_GUARD2_H
+#include "include_guard2.h"
+	assert(guarded_count == 2);
+
+#include "include_guard3.h"
+#include "include_guard3.h"
+	assert(unguarded_count == 2);
+
+	struct guarded g = { 1 };
+	func_A();
+	return g.x - 1;
+}
@@ -0,0 +1,5 @@
+#ifndef INCLUDE_GUARD3_H
+#define INCLUDE_GUARD3_H
+#endif
+// Not an include guard, since this is outside of the conditional.
+unguarded_count++;
@@ -0,0 +1,5 @@
+// Errors in a precompiled header are reported at their position in it.
+
+static int f(void) {
+	return undefined_identifier;
+}
@@ -0,0 +1,14 @@
+#ifndef HEADER_H
+#define HEADER_H
+
+#define VAL 1
+
+struct pair {
+	int a, b;
+};
+
+static int sum(struct pair p) {
+	return p.a + p.b;
+}
+
+#endif
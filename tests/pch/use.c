@@ -0,0 +1,7 @@
+// Compiled with -include-pch of header.h.
+#include <assert.h>
+
+int main(void) {
+	struct pair p = { VAL, 2 };
+	assert(sum(p) == 3);
+}
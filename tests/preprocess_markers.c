@@ -0,0 +1,17 @@
+// Lines starting with expansions, around includes, as written by -E.
+#include "preprocess_markers.h"
+DECLARE(int, x)
+CAT(in, t) y = __LINE__;
+const char *s = STR(a b);
+#include <assert.h>
+EMPTY int w;
+#include <string.h>
+DECLARE(long,
+		z)
+
+int main(void) {
+	assert(y == 4);
+	assert(strcmp(s, STR(a  b)) == 0);
+	x = 1, z = 2, w = 3;
+	assert(x + z + w == 6);
+}
@@ -0,0 +1,4 @@
+#define DECLARE(type, name) type name;
+#define CAT(a, b) a ## b
+#define STR(a) #a
+#define EMPTY
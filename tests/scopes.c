@@ -0,0 +1,47 @@
+#include <assert.h>
+
+int x = 1;
+
+struct s { int a; };
+typedef int t;
+
+#define L(p) int p = 1; sum += p;
+#define L10(p) L(p##0) L(p##1) L(p##2) L(p##3) L(p##4) L(p##5) L(p##6) L(p##7) L(p##8) L(p##9)
+#define L100(p) L10(p##0) L10(p##1) L10(p##2) L10(p##3) L10(p##4) L10(p##5) L10(p##6) L10(p##7) L10(p##8) L10(p##9)
+
+int many_locals(void) {
+	int sum = 0;
+	L100(a) L100(b) L100(c) L100(d) L100(e) L100(f)
+	{
+		L100(g) L100(h) L100(i) L100(j) L100(k) L100(l)
+		int x = 2;
+		assert(x == 2);
+	}
+	assert(x == 1);
+	return sum;
+}
+
+int defined_after_blocks(void);
+
+int main(void) {
+	assert(many_locals() == 1200);
+
+	int x = 2;
+	{
+		struct s { long b; } s = { 3 };
+		typedef char t;
+		int x = 3;
+		assert(x == 3 && s.b == 3 && sizeof (t) == 1);
+		{
+			extern int x;
+			assert(x == 1);
+		}
+	}
+	assert(x == 2);
+	assert(sizeof (struct s) == sizeof (int) && sizeof (t) == sizeof (int));
+	assert(defined_after_blocks() == 4);
+}
+
+int defined_after_blocks(void) {
+	return x + 3;
+}
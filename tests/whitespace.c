@@ -0,0 +1,8 @@
+#include <assert.h>
+
+// Form feed and vertical tab are whitespace, as used in some system headers.
+
+intmain(void) {
+	int a = 1;
+	assert(a == 1);
+}